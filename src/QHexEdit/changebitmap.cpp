@@ -0,0 +1,208 @@
+#include "changebitmap.h"
+
+const int WORD_BITS = 64;
+
+// bits [from, to) of a word, 0 <= from <= to <= 64
+static inline quint64 bitMask(int from, int to)
+{
+    quint64 upper = (to == WORD_BITS) ? ~quint64(0) : ((quint64(1) << to) - 1);
+    return upper & ~((quint64(1) << from) - 1);
+}
+
+static inline int countTrailingZeros(quint64 v)
+{
+#if defined(__GNUC__)
+    return __builtin_ctzll(v);
+#else
+    int n = 0;
+    while (!(v & 1))
+    {
+        v >>= 1;
+        n++;
+    }
+    return n;
+#endif
+}
+
+ChangeBitmap::ChangeBitmap(int size)
+{
+    _size = 0;
+    reset(size);
+}
+
+int ChangeBitmap::size() const
+{
+    return _size;
+}
+
+void ChangeBitmap::reset(int size)
+{
+    _words.fill(0, (qMax(0, size) + WORD_BITS - 1) / WORD_BITS);
+    _size = qMax(0, size);
+}
+
+void ChangeBitmap::resize(int size)
+{
+    size = qMax(0, size);
+    _words.resize((size + WORD_BITS - 1) / WORD_BITS);
+    _size = size;
+
+    // keep the bits beyond the end clear
+    if (_size % WORD_BITS)
+        _words[_size / WORD_BITS] &= bitMask(0, _size % WORD_BITS);
+}
+
+bool ChangeBitmap::testBit(int i) const
+{
+    if ((i < 0) || (i >= _size))
+        return false;
+    return (_words.at(i / WORD_BITS) >> (i % WORD_BITS)) & 1;
+}
+
+void ChangeBitmap::setBit(int i, bool state)
+{
+    if ((i < 0) || (i >= _size))
+        return;
+    if (state)
+        _words[i / WORD_BITS] |= quint64(1) << (i % WORD_BITS);
+    else
+        _words[i / WORD_BITS] &= ~(quint64(1) << (i % WORD_BITS));
+}
+
+void ChangeBitmap::fill(int pos, int len, bool state)
+{
+    if (pos < 0)
+    {
+        len += pos;
+        pos = 0;
+    }
+    int end = qMin(_size, pos + len);
+    while (pos < end)
+    {
+        int w = pos / WORD_BITS;
+        int to = qMin(end - w * WORD_BITS, WORD_BITS);
+        quint64 mask = bitMask(pos % WORD_BITS, to);
+        if (state)
+            _words[w] |= mask;
+        else
+            _words[w] &= ~mask;
+        pos = w * WORD_BITS + to;
+    }
+}
+
+void ChangeBitmap::insert(int pos, int len, bool state)
+{
+    if ((len <= 0) || (pos < 0) || (pos > _size))
+        return;
+
+    ChangeBitmap tail = mid(pos, _size - pos);
+    resize(_size + len);
+    fill(pos, len, state);
+    copyFrom(pos + len, tail, 0, tail.size());
+}
+
+void ChangeBitmap::remove(int pos, int len)
+{
+    if ((pos < 0) || (pos >= _size) || (len <= 0))
+        return;
+    len = qMin(len, _size - pos);
+
+    ChangeBitmap tail = mid(pos + len, _size - pos - len);
+    copyFrom(pos, tail, 0, tail.size());
+    resize(_size - len);
+}
+
+ChangeBitmap ChangeBitmap::mid(int pos, int len) const
+{
+    if ((pos < 0) || (pos >= _size) || (len <= 0))
+        return ChangeBitmap();
+    len = qMin(len, _size - pos);
+
+    ChangeBitmap result(len);
+    result.copyFrom(0, *this, pos, len);
+    return result;
+}
+
+void ChangeBitmap::replace(int pos, const ChangeBitmap &bits)
+{
+    if ((pos < 0) || (pos >= _size))
+        return;
+    copyFrom(pos, bits, 0, qMin(bits.size(), _size - pos));
+}
+
+int ChangeBitmap::nextSet(int from) const
+{
+    if (from < 0)
+        from = 0;
+    if (from >= _size)
+        return _size;
+
+    int w = from / WORD_BITS;
+    quint64 word = _words.at(w) & bitMask(from % WORD_BITS, WORD_BITS);
+    while (word == 0)
+    {
+        if (++w == _words.size())
+            return _size;
+        word = _words.at(w);
+    }
+    return qMin(_size, w * WORD_BITS + countTrailingZeros(word));
+}
+
+int ChangeBitmap::nextClear(int from) const
+{
+    if (from < 0)
+        from = 0;
+    if (from >= _size)
+        return _size;
+
+    // the clear bits beyond the end stop the scan in the last word
+    int w = from / WORD_BITS;
+    quint64 word = ~_words.at(w) & bitMask(from % WORD_BITS, WORD_BITS);
+    while (word == 0)
+    {
+        if (++w == _words.size())
+            return _size;
+        word = ~_words.at(w);
+    }
+    return qMin(_size, w * WORD_BITS + countTrailingZeros(word));
+}
+
+// up to 64 bits starting at pos, in the low bits of the result
+quint64 ChangeBitmap::extract(int pos, int len) const
+{
+    int w = pos / WORD_BITS;
+    int offset = pos % WORD_BITS;
+    quint64 bits = _words.at(w) >> offset;
+    if ((offset != 0) && (offset + len > WORD_BITS))
+        bits |= _words.at(w + 1) << (WORD_BITS - offset);
+    return bits & bitMask(0, len);
+}
+
+void ChangeBitmap::deposit(int pos, int len, quint64 bits)
+{
+    int w = pos / WORD_BITS;
+    int offset = pos % WORD_BITS;
+    int first = qMin(len, WORD_BITS - offset);
+
+    quint64 mask = bitMask(offset, offset + first);
+    _words[w] = (_words.at(w) & ~mask) | ((bits << offset) & mask);
+
+    if (first < len)
+    {
+        mask = bitMask(0, len - first);
+        _words[w + 1] = (_words.at(w + 1) & ~mask) | ((bits >> first) & mask);
+    }
+}
+
+void ChangeBitmap::copyFrom(int pos, const ChangeBitmap &src, int srcPos, int len)
+{
+    // src is never this bitmap, so the ranges do not overlap
+    while (len > 0)
+    {
+        int n = qMin(len, WORD_BITS);
+        deposit(pos, n, src.extract(srcPos, n));
+        pos += n;
+        srcPos += n;
+        len -= n;
+    }
+}
@@ -0,0 +1,46 @@
+#ifndef CHANGEBITMAP_H
+#define CHANGEBITMAP_H
+
+/** \cond docNever */
+
+#include <QtCore>
+
+/*! ChangeBitmap keeps one bit per data byte to remember, if the byte was
+changed. Compared to a byte per data byte it needs an eighth of the memory,
+and runs of changed or unchanged bytes are skipped 64 bytes at a time by
+nextSet() and nextClear(). All positions are clamped to the size of the
+bitmap.
+*/
+class ChangeBitmap
+{
+public:
+    explicit ChangeBitmap(int size = 0);
+
+    int size() const;
+    void reset(int size);               // resize and clear all bits
+    void resize(int size);              // new bits are cleared
+
+    bool testBit(int i) const;
+    void setBit(int i, bool state);
+    void fill(int pos, int len, bool state);
+
+    void insert(int pos, int len, bool state);
+    void remove(int pos, int len);
+
+    ChangeBitmap mid(int pos, int len) const;
+    void replace(int pos, const ChangeBitmap & bits);
+
+    int nextSet(int from) const;        // first set bit at or after from, size() if none
+    int nextClear(int from) const;      // first clear bit at or after from, size() if none
+
+private:
+    quint64 extract(int pos, int len) const;
+    void deposit(int pos, int len, quint64 bits);
+    void copyFrom(int pos, const ChangeBitmap & src, int srcPos, int len);
+
+    QVector<quint64> _words;
+    int _size;                              // bits beyond _size are always clear
+};
+
+/** \endcond docNever */
+#endif // CHANGEBITMAP_H
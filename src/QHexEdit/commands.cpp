@@ -1,29 +1,142 @@
 #include "commands.h"
 
+const int MAX_CHAR_RUN = 256;       // chars merged into one CharCommand at most
+const int PACK_THRESHOLD = 64;      // byte arrays from this size on are packed
+
+// PackBits run-length encoding: a control byte c < 128 is followed by c + 1
+// literal bytes, a control byte c > 128 by one byte repeated 257 - c times
+static QByteArray packBits(const QByteArray &data)
+{
+    const char *p = data.constData();
+    int n = data.size();
+    int i = 0;
+    QByteArray out;
+
+    while (i < n)
+    {
+        int run = 1;
+        while ((i + run < n) && (run < 128) && (p[i + run] == p[i]))
+            run++;
+        if (run >= 3)
+        {
+            out.append(char(257 - run));
+            out.append(p[i]);
+            i += run;
+            continue;
+        }
+
+        // literals up to the next run of three
+        int start = i;
+        int literals = 0;
+        while ((i < n) && (literals < 128))
+        {
+            if ((i + 2 < n) && (p[i] == p[i + 1]) && (p[i] == p[i + 2]))
+                break;
+            i++;
+            literals++;
+        }
+        out.append(char(literals - 1));
+        out.append(p + start, literals);
+    }
+    return out;
+}
+
+static QByteArray unpackBits(const QByteArray &packed, int size)
+{
+    const uchar *p = (const uchar *) packed.constData();
+    int n = packed.size();
+    int i = 0;
+    QByteArray out;
+    out.reserve(size);
+
+    while (i < n)
+    {
+        int c = p[i++];
+        if (c < 128)
+        {
+            out.append((const char *) p + i, c + 1);
+            i += c + 1;
+        }
+        else
+        {
+            out.append(QByteArray(257 - c, char(p[i++])));
+        }
+    }
+    return out;
+}
+
+static QByteArray xorBytes(QByteArray a, const QByteArray &b)
+{
+    char *d = a.data();
+    for (int i = 0; i < a.size(); i++)
+        d[i] ^= b.at(i);
+    return a;
+}
+
+
+
 CharCommand::CharCommand(XByteArray * xData, Cmd cmd, int charPos, char newChar, QUndoCommand *parent)
-    : QUndoCommand(parent)
+    : HexCommand(parent)
 {
     _xData = xData;
     _charPos = charPos;
-    _newChar = newChar;
+    _newChars = QByteArray(1, newChar);
     _cmd = cmd;
 }
 
 bool CharCommand::mergeWith(const QUndoCommand *command)
 {
+    // the next command is already done, so its old chars are known
     const CharCommand *nextCommand = static_cast<const CharCommand *>(command);
-    bool result = false;
+    int len = _newChars.size();
+    int offset = nextCommand->_charPos - _charPos;
+
+    // replacing a char of the run only changes its new value
+    if ((_cmd != remove) && (nextCommand->_cmd == replace) && (offset >= 0) && (offset < len))
+    {
+        _newChars[offset] = nextCommand->_newChars.at(0);
+        return true;
+    }
+
+    if ((nextCommand->_cmd != _cmd) || (len >= MAX_CHAR_RUN))
+        return false;
+
+    // does the next char continue the run at its end or at its start?
+    bool append, prepend;
+    switch (_cmd)
+    {
+        case insert:
+            append = (offset == len);
+            prepend = (offset == 0);
+            break;
+        case remove:
+            append = (offset == 0);
+            prepend = (offset == -1);
+            break;
+        default:
+            append = (offset == len);
+            prepend = (offset == -1);
+            break;
+    }
 
-    if (_cmd != remove)
+    if (append)
+    {
+        _newChars.append(nextCommand->_newChars);
+        _oldChars.append(nextCommand->_oldChars);
+        if (_cmd != insert)
+            _wasChanged.insert(_wasChanged.size(), 1, nextCommand->_wasChanged.testBit(0));
+        return true;
+    }
+    if (prepend)
     {
-        if (nextCommand->_cmd == replace)
-            if (nextCommand->_charPos == _charPos)
-            {
-                _newChar = nextCommand->_newChar;
-                result = true;
-            }
+        _charPos = nextCommand->_charPos;
+        _newChars.prepend(nextCommand->_newChars);
+        _oldChars.prepend(nextCommand->_oldChars);
+        if (_cmd != insert)
+            _wasChanged.insert(0, 1, nextCommand->_wasChanged.testBit(0));
+        return true;
     }
-    return result;
+    return false;
 }
 
 void CharCommand::undo()
@@ -31,14 +144,14 @@ void CharCommand::undo()
     switch (_cmd)
     {
         case insert:
-            _xData->remove(_charPos, 1);
+            _xData->remove(_charPos, _newChars.size());
             break;
         case replace:
-            _xData->replace(_charPos, _oldChar);
+            _xData->replace(_charPos, _oldChars);
             _xData->setDataChanged(_charPos, _wasChanged);
             break;
         case remove:
-            _xData->insert(_charPos, _oldChar);
+            _xData->insert(_charPos, _oldChars);
             _xData->setDataChanged(_charPos, _wasChanged);
             break;
     }
@@ -46,34 +159,46 @@ void CharCommand::undo()
 
 void CharCommand::redo()
 {
+    int len = _newChars.size();
     switch (_cmd)
     {
         case insert:
-            _xData->insert(_charPos, _newChar);
+            _xData->insert(_charPos, _newChars);
             break;
         case replace:
-            _oldChar = _xData->data()[_charPos];
-            _wasChanged = _xData->dataChanged(_charPos);
-            _xData->replace(_charPos, _newChar);
+            _oldChars = _xData->mid(_charPos, len);
+            _wasChanged = _xData->dataChanged(_charPos, len);
+            _xData->replace(_charPos, _newChars);
             break;
         case remove:
-            _oldChar = _xData->data()[_charPos];
-            _wasChanged = _xData->dataChanged(_charPos);
-            _xData->remove(_charPos, 1);
+            _oldChars = _xData->mid(_charPos, len);
+            _wasChanged = _xData->dataChanged(_charPos, len);
+            _xData->remove(_charPos, len);
             break;
     }
 }
 
+int CharCommand::memoryCost() const
+{
+    return sizeof(CharCommand) + _newChars.size() + _oldChars.size() + _wasChanged.size() / 8;
+}
+
 
 
 ArrayCommand::ArrayCommand(XByteArray * xData, Cmd cmd, int baPos, QByteArray newBa, int len, QUndoCommand *parent)
-    : QUndoCommand(parent)
+    : HexCommand(parent)
 {
     _cmd = cmd;
     _xData = xData;
     _baPos = baPos;
     _newBa = newBa;
     _len = len;
+    _newSize = newBa.size();
+    _oldSize = 0;
+    _newPacked = false;
+    _oldPacked = false;
+    _oldXored = false;
+    pack();
 }
 
 void ArrayCommand::undo()
@@ -81,14 +206,14 @@ void ArrayCommand::undo()
     switch (_cmd)
     {
         case insert:
-            _xData->remove(_baPos, _newBa.length());
+            _xData->remove(_baPos, _newSize);
             break;
         case replace:
-            _xData->replace(_baPos, _oldBa);
+            _xData->replace(_baPos, oldData());
             _xData->setDataChanged(_baPos, _wasChanged);
             break;
         case remove:
-            _xData->insert(_baPos, _oldBa);
+            _xData->insert(_baPos, oldData());
             _xData->setDataChanged(_baPos, _wasChanged);
             break;
     }
@@ -99,17 +224,73 @@ void ArrayCommand::redo()
     switch (_cmd)
     {
         case insert:
-            _xData->insert(_baPos, _newBa);
+            _xData->insert(_baPos, newData());
             break;
         case replace:
-            _oldBa = _xData->data().mid(_baPos, _len);
+            _oldBa = _xData->mid(_baPos, _len);
             _wasChanged = _xData->dataChanged(_baPos, _len);
-            _xData->replace(_baPos, _newBa);
+            _xData->replace(_baPos, newData());
             break;
         case remove:
-            _oldBa = _xData->data().mid(_baPos, _len);
+            _oldBa = _xData->mid(_baPos, _len);
             _wasChanged = _xData->dataChanged(_baPos, _len);
             _xData->remove(_baPos, _len);
             break;
     }
+
+    if (_cmd != insert)
+    {
+        _oldSize = _oldBa.size();
+        _oldPacked = false;
+        _oldXored = false;
+        pack();
+    }
+}
+
+int ArrayCommand::memoryCost() const
+{
+    return sizeof(ArrayCommand) + _newBa.size() + _oldBa.size() + _wasChanged.size() / 8;
+}
+
+QByteArray ArrayCommand::newData() const
+{
+    return _newPacked ? unpackBits(_newBa, _newSize) : _newBa;
+}
+
+QByteArray ArrayCommand::oldData() const
+{
+    QByteArray old = _oldPacked ? unpackBits(_oldBa, _oldSize) : _oldBa;
+    if (_oldXored)
+        old = xorBytes(old, newData());
+    return old;
+}
+
+void ArrayCommand::pack()
+{
+    if (!_newPacked && (_newBa.size() >= PACK_THRESHOLD))
+    {
+        QByteArray packed = packBits(_newBa);
+        if (packed.size() < _newBa.size())
+        {
+            _newBa = packed;
+            _newPacked = true;
+        }
+    }
+
+    if (!_oldPacked && (_oldBa.size() >= PACK_THRESHOLD))
+    {
+        // bytes left unchanged by a replace become runs of zeros
+        QByteArray old = _oldBa;
+        bool xored = (_cmd == replace) && (_oldSize == _newSize);
+        if (xored)
+            old = xorBytes(old, newData());
+
+        QByteArray packed = packBits(old);
+        if (packed.size() < _oldBa.size())
+        {
+            _oldBa = packed;
+            _oldPacked = true;
+            _oldXored = xored;
+        }
+    }
 }
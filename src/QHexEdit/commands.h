@@ -7,6 +7,17 @@
 
 #include "xbytearray.h"
 
+/*! HexCommand is the base of the undo/redo commands of QHexEdit. Besides
+undo and redo, every command reports how much memory it holds, so that the
+UndoStack can keep all commands within a memory budget.
+*/
+class HexCommand : public QUndoCommand
+{
+public:
+    HexCommand(QUndoCommand *parent=0) : QUndoCommand(parent) {}
+    virtual int memoryCost() const = 0;
+};
+
 /*! CharCommand is a class to prived undo/redo functionality in QHexEdit.
 A QUndoCommand represents a single editing action on a document. CharCommand
 is responsable for manipulations on single chars. It can insert. replace and
@@ -19,8 +30,12 @@ the user to execute a undo command contation e.g. 3 steps in a single command.
 If you for example insert a new byt "34" this means for the editor doing 3
 steps: insert a "00", replace it with "03" and the replace it with "34". These
 3 steps are combined into a single step, insert a "34".
+
+Beyond that, a CharCommand grows into a run of adjacent chars: typing over
+or inserting consecutive bytes, and deleting with del or backspace, is merged
+into one command of up to MAX_CHAR_RUN chars.
 */
-class CharCommand : public QUndoCommand
+class CharCommand : public HexCommand
 {
 public:
     enum { Id = 1234 };
@@ -33,20 +48,25 @@ public:
     void redo();
     bool mergeWith(const QUndoCommand *command);
     int id() const { return Id; }
+    int memoryCost() const;
 
 private:
     XByteArray * _xData;
-    int _charPos;
-    bool _wasChanged;
-    char _newChar;
-    char _oldChar;
+    int _charPos;                   // first char of the run
+    ChangeBitmap _wasChanged;
+    QByteArray _newChars;
+    QByteArray _oldChars;
     Cmd _cmd;
 };
 
 /*! ArrayCommand provides undo/redo functionality for handling binary strings. It
 can undo/redo insert, replace and remove binary strins (QByteArrays).
+
+Large byte arrays are kept run-length encoded, and the replaced bytes are kept
+as xor against the new bytes, so that fills and pastes which change little
+cost little memory.
 */
-class ArrayCommand : public QUndoCommand
+class ArrayCommand : public HexCommand
 {
 public:
     enum Cmd {insert, remove, replace};
@@ -54,15 +74,24 @@ public:
                  QUndoCommand *parent=0);
     void undo();
     void redo();
+    int memoryCost() const;
 
 private:
+    QByteArray newData() const;
+    QByteArray oldData() const;
+    void pack();
+
     Cmd _cmd;
     XByteArray * _xData;
     int _baPos;
     int _len;
-    QByteArray _wasChanged;
+    ChangeBitmap _wasChanged;
     QByteArray _newBa;
     QByteArray _oldBa;
+    int _newSize, _oldSize;         // unpacked sizes
+    bool _newPacked;                // _newBa is run-length encoded
+    bool _oldPacked;                // _oldBa is run-length encoded
+    bool _oldXored;                 // _oldBa is xored with the new bytes
 };
 
 /** \endcond docNever */
@@ -0,0 +1,101 @@
+#include <string.h>
+#include "hexdumpwriter.h"
+
+const int BYTES_PER_LINE = 16;
+const int HEX_FIELD_WIDTH = 3 * BYTES_PER_LINE;     // " xx" per byte
+const int ASCII_FIELD_WIDTH = BYTES_PER_LINE + 1;
+const int BUFFER_LINES = 4096;                      // formatted before writing
+
+static const char hexDigits[] = "0123456789abcdef";
+
+// hex digits and ascii character of every byte value
+struct DumpTables
+{
+    DumpTables()
+    {
+        for (int c = 0; c < 256; c++)
+        {
+            hex[c][0] = hexDigits[c >> 4];
+            hex[c][1] = hexDigits[c & 0x0f];
+            ascii[c] = ((c < 0x20) || (c > 0x7e)) ? '.' : char(c);
+        }
+    }
+
+    char hex[256][2];
+    char ascii[256];
+};
+
+static const DumpTables tables;
+
+HexDumpWriter::HexDumpWriter(QIODevice *device, int addressWidth)
+{
+    _device = device;
+    _addressWidth = addressWidth;
+
+    // addresses wider than addressWidth are not cut, so reserve room for 8 digits
+    _lineLength = qMax(addressWidth, 8) + 1 + HEX_FIELD_WIDTH + 2 + ASCII_FIELD_WIDTH + 1;
+    _buffer.resize(BUFFER_LINES * _lineLength);
+    _end = _buffer.data();
+    _ok = true;
+}
+
+HexDumpWriter::~HexDumpWriter()
+{
+    flush();
+}
+
+bool HexDumpWriter::write(int address, const char *data, int len)
+{
+    const char *bufferEnd = _buffer.constData() + _buffer.size();
+    for (int i = 0; i < len; i += BYTES_PER_LINE)
+    {
+        if (bufferEnd - _end < _lineLength)
+            flush();
+        formatLine(address + i, data + i, qMin(BYTES_PER_LINE, len - i));
+    }
+    return _ok;
+}
+
+bool HexDumpWriter::flush()
+{
+    qint64 len = _end - _buffer.constData();
+    if (len > 0)
+    {
+        if (_device->write(_buffer.constData(), len) != len)
+            _ok = false;
+        _end = _buffer.data();
+    }
+    return _ok;
+}
+
+void HexDumpWriter::formatLine(int address, const char *data, int len)
+{
+    char *p = _end;
+
+    // address, right aligned and padded with zeros
+    uint adr = uint(address);
+    int digits = 1;
+    while ((digits < 8) && (adr >> (4 * digits)))
+        digits++;
+    for (int i = _addressWidth; i > digits; i--)
+        *p++ = '0';
+    for (int i = digits - 1; i >= 0; i--)
+        *p++ = hexDigits[(adr >> (4 * i)) & 0x0f];
+    *p++ = ' ';
+
+    // hex field, then two blanks and the ascii field, both filled with blanks
+    char *hex = p;
+    char *ascii = p + HEX_FIELD_WIDTH + 2;
+    memset(p, ' ', HEX_FIELD_WIDTH + 2 + ASCII_FIELD_WIDTH);
+    for (int i = 0; i < len; i++)
+    {
+        uchar c = uchar(data[i]);
+        hex[3 * i + 1] = tables.hex[c][0];
+        hex[3 * i + 2] = tables.hex[c][1];
+        ascii[i] = tables.ascii[c];
+    }
+    p += HEX_FIELD_WIDTH + 2 + ASCII_FIELD_WIDTH;
+    *p++ = '\n';
+
+    _end = p;
+}
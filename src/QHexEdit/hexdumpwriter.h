@@ -0,0 +1,37 @@
+#ifndef HEXDUMPWRITER_H
+#define HEXDUMPWRITER_H
+
+/** \cond docNever */
+
+#include <QtCore>
+
+/*! HexDumpWriter formats data as readable lines of 16 bytes each (address,
+hex bytes and ascii characters) and writes them to a QIODevice. Lines are
+formatted with lookup tables into a buffer of fixed size, which is written
+to the device whenever it is full, so any amount of data is exported in
+bounded memory.
+*/
+class HexDumpWriter
+{
+public:
+    HexDumpWriter(QIODevice *device, int addressWidth);
+    ~HexDumpWriter();                       // flushes
+
+    // data starts a line at address, the last line may be shorter
+    bool write(int address, const char *data, int len);
+    bool flush();
+
+private:
+    Q_DISABLE_COPY(HexDumpWriter)
+    void formatLine(int address, const char *data, int len);
+
+    QIODevice *_device;
+    int _addressWidth;
+    int _lineLength;
+    QByteArray _buffer;
+    char *_end;                             // end of the formatted lines in _buffer
+    bool _ok;                               // no write to the device failed
+};
+
+/** \endcond docNever */
+#endif // HEXDUMPWRITER_H
@@ -0,0 +1,374 @@
+#include <string.h>
+#include "piecetable.h"
+
+PieceTable::PieceTable()
+{
+    _root = -1;
+    _seed = 0x2545f491;
+    _cacheValid = true;
+    _mapped = false;
+}
+
+void PieceTable::setData(const QByteArray &data)
+{
+    _original = data;
+    _added.clear();
+    _nodes.clear();
+    _free.clear();
+    _root = -1;
+    if (data.size() > 0)
+        _root = allocate(false, 0, data.size());
+
+    _cache = data;
+    _cacheValid = true;
+    _mapped = false;
+}
+
+void PieceTable::setMappedData(const QByteArray &data)
+{
+    setData(data);
+
+    // reading through the pieces keeps the mapping from being copied
+    _cache.clear();
+    _cacheValid = false;
+    _mapped = true;
+}
+
+const QByteArray & PieceTable::data()
+{
+    if (!_cacheValid)
+    {
+        QByteArray content;
+        content.resize(size());
+        collect(_root, 0, 0, size(), content.data());
+
+        if (_mapped)
+        {
+            _cache = content;
+            _cacheValid = true;
+        }
+        else
+        {
+            // start over from a single piece, which also frees the bytes of
+            // _added that are no longer referenced
+            setData(content);
+        }
+    }
+    return _cache;
+}
+
+int PieceTable::size() const
+{
+    return total(_root);
+}
+
+char PieceTable::at(int i) const
+{
+    if (_cacheValid)
+        return _cache.at(i);
+
+    int t = _root;
+    while (t >= 0)
+    {
+        const Piece &piece = _nodes.at(t);
+        int leftSize = total(piece.left);
+        if (i < leftSize)
+            t = piece.left;
+        else if (i < leftSize + piece.length)
+            return bytes(piece)[i - leftSize];
+        else
+        {
+            i -= leftSize + piece.length;
+            t = piece.right;
+        }
+    }
+    return char(0);
+}
+
+QByteArray PieceTable::mid(int pos, int len) const
+{
+    if (pos < 0)
+    {
+        len += pos;
+        pos = 0;
+    }
+    int end = qMin(size(), pos + len);
+    if (pos >= end)
+        return QByteArray();
+
+    if (_cacheValid)
+        return _cache.mid(pos, end - pos);
+
+    QByteArray result;
+    result.resize(end - pos);
+    collect(_root, 0, pos, end, result.data());
+    return result;
+}
+
+int PieceTable::read(int pos, int len, char *dest) const
+{
+    if (pos < 0)
+    {
+        len += pos;
+        pos = 0;
+    }
+    int end = qMin(size(), pos + len);
+    if (pos >= end)
+        return 0;
+
+    if (_cacheValid)
+        memcpy(dest, _cache.constData() + pos, end - pos);
+    else
+        collect(_root, 0, pos, end, dest);
+    return end - pos;
+}
+
+const char *PieceTable::constData()
+{
+    // a mapping that is only cut, but not edited, is contiguous already
+    if (_mapped && !_cacheValid && (_root >= 0))
+    {
+        const Piece &piece = _nodes.at(_root);
+        if ((piece.left < 0) && (piece.right < 0) && !piece.added)
+            return _original.constData() + piece.start;
+    }
+    return data().constData();
+}
+
+void PieceTable::insert(int pos, const QByteArray &ba)
+{
+    if (ba.isEmpty() || (pos < 0) || (pos > size()))
+        return;
+
+    int piece = allocate(true, _added.size(), ba.size());
+    _added.append(ba);
+
+    int l, r;
+    split(_root, pos, l, r);
+    _root = merge(merge(l, piece), r);
+
+    _cacheValid = false;
+    _cache.clear();
+}
+
+void PieceTable::remove(int pos, int len)
+{
+    if ((pos < 0) || (pos >= size()) || (len <= 0))
+        return;
+
+    int l, m, r;
+    split(_root, pos, l, m);
+    split(m, len, m, r);
+    release(m);
+    _root = merge(l, r);
+
+    _cacheValid = false;
+    _cache.clear();
+}
+
+void PieceTable::replace(int pos, const QByteArray &ba)
+{
+    int len = qMin(ba.size(), size() - pos);
+    if ((pos < 0) || (len <= 0))
+        return;
+
+    if (_cacheValid && !_mapped)
+    {
+        // the content is then a single piece over _original, which shares
+        // its bytes with _cache; patching them keeps it that way and does
+        // not grow _added. _original lets go first, so that the shared
+        // bytes are not copied
+        _original = QByteArray();
+        _cache.replace(pos, len, ba.constData(), len);
+        _original = _cache;
+        return;
+    }
+
+    int piece = allocate(true, _added.size(), len);
+    _added.append(ba.constData(), len);
+
+    int l, m, r;
+    split(_root, pos, l, m);
+    split(m, len, m, r);
+    release(m);
+    _root = merge(merge(l, piece), r);
+
+    // the size did not change, so the cache of a mapping can be patched
+    // in place; its pieces are kept for modifiedRanges()
+    if (_cacheValid)
+        _cache.replace(pos, len, ba.constData(), len);
+}
+
+int PieceTable::pieceCount() const
+{
+    return _nodes.size() - _free.size();
+}
+
+QList<QPair<int, int> > PieceTable::modifiedRanges() const
+{
+    QList<QPair<int, int> > ranges;
+    collectModified(_root, 0, ranges);
+    return ranges;
+}
+
+int PieceTable::allocate(bool added, int start, int length)
+{
+    // xorshift, the priorities only have to be well mixed
+    _seed ^= _seed << 13;
+    _seed ^= _seed >> 17;
+    _seed ^= _seed << 5;
+
+    Piece piece;
+    piece.left = -1;
+    piece.right = -1;
+    piece.priority = _seed;
+    piece.added = added;
+    piece.start = start;
+    piece.length = length;
+    piece.total = length;
+
+    if (_free.isEmpty())
+    {
+        _nodes.append(piece);
+        return _nodes.size() - 1;
+    }
+
+    int t = _free.last();
+    _free.removeLast();
+    _nodes[t] = piece;
+    return t;
+}
+
+void PieceTable::release(int t)
+{
+    if (t < 0)
+        return;
+    release(_nodes.at(t).left);
+    release(_nodes.at(t).right);
+    _free.append(t);
+}
+
+void PieceTable::update(int t)
+{
+    Piece &piece = _nodes[t];
+    piece.total = total(piece.left) + piece.length + total(piece.right);
+}
+
+int PieceTable::total(int t) const
+{
+    return (t < 0) ? 0 : _nodes.at(t).total;
+}
+
+// l receives the first pos bytes of subtree t, r the rest
+void PieceTable::split(int t, int pos, int &l, int &r)
+{
+    if (t < 0)
+    {
+        l = -1;
+        r = -1;
+        return;
+    }
+
+    // no references into _nodes are held across calls, since cutting a
+    // piece in two may grow it
+    int leftSize = total(_nodes.at(t).left);
+    int length = _nodes.at(t).length;
+    int a, b;
+
+    if (pos <= leftSize)
+    {
+        split(_nodes.at(t).left, pos, a, b);
+        _nodes[t].left = b;
+        update(t);
+        l = a;
+        r = t;
+    }
+    else if (pos >= leftSize + length)
+    {
+        split(_nodes.at(t).right, pos - leftSize - length, a, b);
+        _nodes[t].right = a;
+        update(t);
+        l = t;
+        r = b;
+    }
+    else
+    {
+        // pos lies inside the piece itself
+        int offset = pos - leftSize;
+        int tail = allocate(_nodes.at(t).added, _nodes.at(t).start + offset, length - offset);
+        int right = _nodes.at(t).right;
+        _nodes[t].length = offset;
+        _nodes[t].right = -1;
+        update(t);
+        l = t;
+        r = merge(tail, right);
+    }
+}
+
+int PieceTable::merge(int l, int r)
+{
+    if (l < 0)
+        return r;
+    if (r < 0)
+        return l;
+
+    if (_nodes.at(l).priority > _nodes.at(r).priority)
+    {
+        int right = merge(_nodes.at(l).right, r);
+        _nodes[l].right = right;
+        update(l);
+        return l;
+    }
+    else
+    {
+        int left = merge(l, _nodes.at(r).left);
+        _nodes[r].left = left;
+        update(r);
+        return r;
+    }
+}
+
+// appends the bytes [pos, end) of subtree t, which starts at offset
+// out receives the byte at pos
+void PieceTable::collect(int t, int offset, int pos, int end, char *out) const
+{
+    if ((t < 0) || (offset >= end) || (offset + total(t) <= pos))
+        return;
+
+    const Piece &piece = _nodes.at(t);
+    int leftSize = total(piece.left);
+    collect(piece.left, offset, pos, end, out);
+
+    int from = qMax(pos, offset + leftSize);
+    int to = qMin(end, offset + leftSize + piece.length);
+    if (from < to)
+        memcpy(out + (from - pos), bytes(piece) + (from - offset - leftSize), to - from);
+
+    collect(piece.right, offset + leftSize + piece.length, pos, end, out);
+}
+
+// bytes still at their position in the original data are unmodified
+void PieceTable::collectModified(int t, int offset, QList<QPair<int, int> > &out) const
+{
+    if (t < 0)
+        return;
+
+    const Piece &piece = _nodes.at(t);
+    int pos = offset + total(piece.left);
+    collectModified(piece.left, offset, out);
+
+    if (piece.added || (piece.start != pos))
+    {
+        if (!out.isEmpty() && (out.last().first + out.last().second == pos))
+            out.last().second += piece.length;
+        else
+            out.append(qMakePair(pos, piece.length));
+    }
+
+    collectModified(piece.right, pos + piece.length, out);
+}
+
+const char * PieceTable::bytes(const Piece &piece) const
+{
+    return (piece.added ? _added.constData() : _original.constData()) + piece.start;
+}
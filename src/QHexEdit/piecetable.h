@@ -0,0 +1,79 @@
+#ifndef PIECETABLE_H
+#define PIECETABLE_H
+
+/** \cond docNever */
+
+#include <QtCore>
+
+/*! PieceTable stores the content of QHexEdit as a sequence of pieces, each
+refering to a stretch of either the original data or of an append-only buffer
+holding all inserted bytes. The pieces are kept in a treap ordered by their
+position, so that insert, remove and replace split and join O(log n) pieces
+instead of moving the tail of the data.
+
+Contiguous bytes are only built by data(), which caches them and collapses the
+pieces into a single one again. Replacing bytes without changing the size
+updates the cache in place, so overwrite-mode editing does not invalidate it,
+nor add pieces while the cache is valid.
+
+With setMappedData() the original data is a file mapping, which is never
+copied: nothing is cached up front, and the pieces are kept after data() so
+that modifiedRanges() can tell which bytes differ from the file.
+*/
+class PieceTable
+{
+public:
+    explicit PieceTable();
+
+    void setData(const QByteArray & data);
+    void setMappedData(const QByteArray & data);
+    const QByteArray & data();
+    const char *constData();                // like data(), an unmodified mapping is not copied
+
+    int size() const;
+    char at(int i) const;
+    QByteArray mid(int pos, int len) const;
+    int read(int pos, int len, char *dest) const;   // copies up to len bytes, returns their number
+
+    void insert(int pos, const QByteArray & ba);
+    void remove(int pos, int len);
+    void replace(int pos, const QByteArray & ba);   // overwrites ba.size() bytes
+
+    int pieceCount() const;
+    QList<QPair<int, int> > modifiedRanges() const;     // (position, length), ascending
+
+private:
+    struct Piece
+    {
+        int left, right;                    // children in the treap, -1 if none
+        quint32 priority;
+        bool added;                         // bytes are in _added, not in _original
+        int start;                          // first byte in the buffer
+        int length;
+        int total;                          // bytes in the whole subtree
+    };
+
+    int allocate(bool added, int start, int length);
+    void release(int t);
+    void update(int t);
+    int total(int t) const;
+    void split(int t, int pos, int & l, int & r);
+    int merge(int l, int r);
+    void collect(int t, int offset, int pos, int end, char *out) const;
+    void collectModified(int t, int offset, QList<QPair<int, int> > & out) const;
+    const char *bytes(const Piece & piece) const;
+
+    QByteArray _original;
+    QByteArray _added;
+    QVector<Piece> _nodes;
+    QVector<int> _free;                     // released entries of _nodes
+    int _root;
+    quint32 _seed;                          // state of the priority generator
+
+    QByteArray _cache;                      // contiguous content, if _cacheValid
+    bool _cacheValid;
+    bool _mapped;                           // _original is a file mapping
+};
+
+/** \endcond docNever */
+#endif // PIECETABLE_H
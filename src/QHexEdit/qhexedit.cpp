@@ -3,11 +3,10 @@
 #include "qhexedit.h"
 
 
-QHexEdit::QHexEdit(QWidget *parent) : QScrollArea(parent)
+QHexEdit::QHexEdit(QWidget *parent) : QAbstractScrollArea(parent)
 {
     qHexEdit_p = new QHexEditPrivate(this);
-    setWidget(qHexEdit_p);
-    setWidgetResizable(true);
+    setViewport(qHexEdit_p);
 
     connect(qHexEdit_p, SIGNAL(currentAddressChanged(int)), this, SIGNAL(currentAddressChanged(int)));
     connect(qHexEdit_p, SIGNAL(currentSizeChanged(int)), this, SIGNAL(currentSizeChanged(int)));
@@ -16,6 +15,15 @@ QHexEdit::QHexEdit(QWidget *parent) : QScrollArea(parent)
     setFocusPolicy(Qt::NoFocus);
 }
 
+bool QHexEdit::viewportEvent(QEvent *event)
+{
+    // QHexEditPrivate paints and handles input itself, wheel events are
+    // turned into scroll bar steps by QAbstractScrollArea
+    if (event->type() == QEvent::Wheel)
+        return QAbstractScrollArea::viewportEvent(event);
+    return false;
+}
+
 int QHexEdit::indexOf(const QByteArray & ba, int from) const
 {
     return qHexEdit_p->indexOf(ba, from);
@@ -46,6 +54,31 @@ void QHexEdit::replace( int pos, int len, const QByteArray & after)
     qHexEdit_p->replace(pos, len, after);
 }
 
+void QHexEdit::setDataChanged(int pos, int len, bool changed)
+{
+    qHexEdit_p->setDataChanged(pos, len, changed);
+}
+
+bool QHexEdit::setSearchPattern(const QString &pattern)
+{
+    return qHexEdit_p->setSearchPattern(pattern);
+}
+
+QVector<int> QHexEdit::searchMatches() const
+{
+    return qHexEdit_p->searchMatches();
+}
+
+int QHexEdit::findNext(int from)
+{
+    return qHexEdit_p->findNext(from);
+}
+
+int QHexEdit::indexOfChanged(int from, int *length) const
+{
+    return qHexEdit_p->indexOfChanged(from, length);
+}
+
 QString QHexEdit::toReadableString()
 {
     return qHexEdit_p->toRedableString();
@@ -56,6 +89,16 @@ QString QHexEdit::selectionToReadableString()
     return qHexEdit_p->selectionToReadableString();
 }
 
+bool QHexEdit::writeReadableString(QIODevice *device)
+{
+    return qHexEdit_p->writeReadableString(device);
+}
+
+bool QHexEdit::writeSelectionReadableString(QIODevice *device)
+{
+    return qHexEdit_p->writeSelectionReadableString(device);
+}
+
 void QHexEdit::setAddressArea(bool addressArea)
 {
     qHexEdit_p->setAddressArea(addressArea);
@@ -71,6 +114,21 @@ void QHexEdit::undo()
     qHexEdit_p->undo();
 }
 
+void QHexEdit::setWordDecoder(WordDecoder decoder, int width)
+{
+    qHexEdit_p->setWordDecoder(decoder, width);
+}
+
+void QHexEdit::setUndoMemoryLimit(int bytes)
+{
+    qHexEdit_p->setUndoMemoryLimit(bytes);
+}
+
+int QHexEdit::undoMemoryLimit()
+{
+    return qHexEdit_p->undoMemoryLimit();
+}
+
 void QHexEdit::setAddressWidth(int addressWidth)
 {
     qHexEdit_p->setAddressWidth(addressWidth);
@@ -119,6 +177,36 @@ QByteArray QHexEdit::data()
     return qHexEdit_p->data();
 }
 
+QByteArray QHexEdit::dataAt(int pos, int len)
+{
+    return qHexEdit_p->dataAt(pos, len);
+}
+
+const char *QHexEdit::constData()
+{
+    return qHexEdit_p->constData();
+}
+
+int QHexEdit::dataSize()
+{
+    return qHexEdit_p->dataSize();
+}
+
+int QHexEdit::read(int pos, int len, char *dest)
+{
+    return qHexEdit_p->read(pos, len, dest);
+}
+
+bool QHexEdit::openFile(const QString &fileName)
+{
+    return qHexEdit_p->openFile(fileName);
+}
+
+bool QHexEdit::saveFile(const QString &fileName)
+{
+    return qHexEdit_p->saveFile(fileName);
+}
+
 void QHexEdit::setAddressAreaColor(const QColor &color)
 {
     qHexEdit_p->setAddressAreaColor(color);
@@ -149,6 +237,16 @@ QColor QHexEdit::selectionColor()
     return qHexEdit_p->selectionColor();
 }
 
+void QHexEdit::setSearchColor(const QColor &color)
+{
+    qHexEdit_p->setSearchColor(color);
+}
+
+QColor QHexEdit::searchColor()
+{
+    return qHexEdit_p->searchColor();
+}
+
 void QHexEdit::setOverwriteMode(bool overwriteMode)
 {
     qHexEdit_p->setOverwriteMode(overwriteMode);
@@ -43,11 +43,11 @@ content for the editor. You can search data inside the content with indexOf()
 and lastIndexOf(). The replace() function is to change located subdata. This
 'replaced' data can also be undone by the undo/redo framework.
 
-This widget can only handle small amounts of data. The size has to be below 10
-megabytes, otherwise the scroll sliders ard not shown and you can't scroll any
-more.
+The editor itself is the viewport of the scroll area. The scroll position is
+kept in lines, and only the lines inside the viewport are painted, so scrolling
+through large data is as fast as through a few bytes.
 */
-        class QHexEdit : public QScrollArea
+        class QHexEdit : public QAbstractScrollArea
 {
     Q_OBJECT
     /*! Property data holds the content of QHexEdit. Call setData() to set the
@@ -84,6 +84,12 @@ more.
     */
     Q_PROPERTY(QColor selectionColor READ selectionColor WRITE setSelectionColor)
 
+    /*! Property search color sets (setSearchColor()) the background color of
+    the matches of the search pattern. You can also read the color
+    (searchColor()).
+    */
+    Q_PROPERTY(QColor searchColor READ searchColor WRITE setSearchColor)
+
     /*! Porperty overwrite mode sets (setOverwriteMode()) or gets (overwriteMode()) the mode
     in which the editor works. In overwrite mode the user will overwrite existing data. The
     size of data will be constant. In insert mode the size will grow, when inserting
@@ -153,6 +159,90 @@ public:
     */
     void replace( int pos, int len, const QByteArray & after);
 
+    /*! Marks len bytes from index position pos as changed (or unchanged), so
+    that they are highlighted like edited data. This can be used to show the
+    differences to another data set. The marks are reset by setData().
+    */
+    void setDataChanged(int pos, int len, bool changed = true);
+
+    /*! Sets the pattern, whose matches are highlighted. The pattern is written
+    as hex digits, where '?' stands for any nibble, e.g. "3c ?? 0? 8f" for an
+    instruction encoding with wildcard fields. All matches are found at once
+    and kept up to date while the data is edited. An empty pattern removes
+    the highlighting. Returns false if the pattern can't be parsed.
+    */
+    bool setSearchPattern(const QString &pattern);
+
+    /*! Returns the index positions of all matches of the search pattern, in
+    ascending order.
+    */
+    QVector<int> searchMatches() const;
+
+    /*! Selects the first match of the search pattern at or after index
+    position from, wrapping around at the end, and returns its index
+    position. Returns -1 if there is no match.
+    */
+    int findNext(int from);
+
+    /*! Returns the index position of the first changed byte at or after
+    index position from, or -1 if no byte there is changed. If length is not
+    null, it receives the number of consecutive changed bytes starting there,
+    so that changed data can be written back range by range.
+    */
+    int indexOfChanged(int from = 0, int *length = 0) const;
+
+    /*! Gives back len bytes from index position pos, without building the
+    whole content like data() does.
+    */
+    QByteArray dataAt(int pos, int len);
+
+    /*! Gives read-only access to the content without copying it. The
+    content is made contiguous first if edits split it; an unedited file
+    opened with openFile() is accessed in place. The pointer stays valid
+    until the content is changed. dataSize() bytes can be read from it.
+    */
+    const char *constData();
+
+    /*! Returns the number of bytes of the content.
+    */
+    int dataSize();
+
+    /*! Copies up to len bytes from index position pos to dest, without
+    building the whole content and without allocating. Returns the number of
+    bytes copied, which is less than len at the end of the content.
+    */
+    int read(int pos, int len, char *dest);
+
+    /*! Shows the content of the file fileName. The file is mapped into memory
+    read-only instead of being loaded, and edits are kept in memory on top of
+    it, so even large files are opened instantly. Like setData(), this clears
+    the undo/redo framework. Returns false if the file can't be mapped.
+    */
+    bool openFile(const QString &fileName);
+
+    /*! Writes the content to the file fileName. If it is the file opened with
+    openFile() and the size did not change, only the pages containing edited
+    bytes are written. Returns false if writing fails.
+    */
+    bool saveFile(const QString &fileName);
+
+    /*! Shows the word area right of the other areas. It shows every 32 bit
+    little-endian word of a line decoded by decoder, e.g. as a number or as
+    a disassembled instruction, each one padded to width characters; longer
+    ones are cut and end in an ellipsis.
+    The decoder gets the word and its address (including addressOffset()).
+    Decoded lines are cached and only decoded again after they were edited,
+    so the decoder may be slow. A decoder of 0 hides the word area.
+    */
+    void setWordDecoder(WordDecoder decoder, int width = 12);
+
+    /*! Limits the memory held by the undo/redo framework to about bytes. When
+    an edit exceeds the limit, the oldest undo steps are discarded. The
+    default is 16 megabytes.
+    */
+    void setUndoMemoryLimit(int bytes);
+    int undoMemoryLimit();
+
     /*! Gives back a formatted image of the content of QHexEdit
     */
     QString toReadableString();
@@ -161,6 +251,17 @@ public:
     */
     QString selectionToReadableString();
 
+    /*! Writes the same formatted image as toReadableString() to device. The
+    image is written in pieces, so large content is exported without holding
+    the image in memory. Returns false if writing to device fails.
+    */
+    bool writeReadableString(QIODevice *device);
+
+    /*! Writes the same formatted image as selectionToReadableString() to
+    device. Returns false if writing to device fails.
+    */
+    bool writeSelectionReadableString(QIODevice *device);
+
     /*! \cond docNever */
     void setAddressOffset(int offset);
     int addressOffset();
@@ -227,11 +328,15 @@ signals:
     /*! The signal is emited every time, the overwrite mode is changed. */
     void overwriteModeChanged(bool state);
 
+protected:
+    /*! \cond docNever */
+    bool viewportEvent(QEvent *event);
+    /*! \endcond docNever */
+
 private:
     /*! \cond docNever */
     QHexEditPrivate *qHexEdit_p;
     QHBoxLayout *layout;
-    QScrollArea *scrollArea;
     /*! \endcond docNever */
 };
 
@@ -8,10 +8,38 @@ const int HEXCHARS_IN_LINE = 47;
 const int GAP_ADR_HEX = 10;
 const int GAP_HEX_ASCII = 16;
 const int BYTES_PER_LINE = 16;
+const int WORDS_PER_LINE = BYTES_PER_LINE / 4;
+const int WORD_CACHE_LINES = 4096;          // decoded lines kept by the word area
+#ifdef QHEXEDIT_PAINT_BENCHMARK
+const int PAINT_BENCHMARK_FRAMES = 100;
+#endif
 
-QHexEditPrivate::QHexEditPrivate(QScrollArea *parent) : QWidget(parent)
+QHexEditPrivate::QHexEditPrivate(QAbstractScrollArea *parent) : QWidget(parent)
 {
-    _undoStack = new QUndoStack(this);
+    // the setters below already adjust the geometry and move the cursor,
+    // so everything they read has to be defined first
+    _blink = false;
+    _charWidth = 0;
+    _charHeight = 0;
+    _charAscent = 0;
+    _cursorX = 0;
+    _cursorLine = 0;
+    _cursorPosition = 0;
+    _xPosAdr = 0;
+    _xPosHex = 0;
+    _xPosAscii = 0;
+    _xPosWords = 0;
+    _contentWidth = 0;
+    _selectionBegin = 0;
+    _selectionEnd = 0;
+    _selectionInit = 0;
+    _size = 0;
+
+    _undoStack = new UndoStack(this);
+
+    _wordDecoder = 0;
+    _wordWidth = 0;
+    _wordLines.setMaxCost(WORD_CACHE_LINES);
 
     _scrollArea = parent;
     setAddressWidth(4);
@@ -24,11 +52,16 @@ QHexEditPrivate::QHexEditPrivate(QScrollArea *parent) : QWidget(parent)
     setAddressAreaColor(QColor(0xd4, 0xd4, 0xd4, 0xff));
     setHighlightingColor(QColor(0xff, 0xff, 0x99, 0xff));
     setSelectionColor(QColor(0x6d, 0x9e, 0xff, 0xff));
+    setSearchColor(QColor(0xff, 0xc8, 0x7c, 0xff));
     setFont(QFont("Courier", 10));
 
-    _size = 0;
     resetSelection(0);
 
+#ifdef QHEXEDIT_PAINT_BENCHMARK
+    _paintTime = 0;
+    _paintFrames = 0;
+#endif
+
     setFocusPolicy(Qt::StrongFocus);
 
     connect(&_cursorTimer, SIGNAL(timeout()), this, SLOT(updateCursor()));
@@ -60,6 +93,41 @@ QByteArray QHexEditPrivate::data()
     return _xData.data();
 }
 
+QByteArray QHexEditPrivate::dataAt(int pos, int len)
+{
+    return _xData.mid(pos, len);
+}
+
+const char *QHexEditPrivate::constData()
+{
+    return _xData.constData();
+}
+
+int QHexEditPrivate::dataSize()
+{
+    return _xData.size();
+}
+
+int QHexEditPrivate::read(int pos, int len, char *dest)
+{
+    return _xData.read(pos, len, dest);
+}
+
+bool QHexEditPrivate::openFile(const QString &fileName)
+{
+    if (!_xData.openFile(fileName))
+        return false;
+    _undoStack->clear();
+    adjust();
+    setCursorPos(0);
+    return true;
+}
+
+bool QHexEditPrivate::saveFile(const QString &fileName)
+{
+    return _xData.saveFile(fileName);
+}
+
 void QHexEditPrivate::setAddressAreaColor(const QColor &color)
 {
     _addressAreaColor = color;
@@ -103,6 +171,17 @@ bool QHexEditPrivate::isReadOnly()
     return _readOnly;
 }
 
+void QHexEditPrivate::setSearchColor(const QColor &color)
+{
+    _searchColor = color;
+    update();
+}
+
+QColor QHexEditPrivate::searchColor()
+{
+    return _searchColor;
+}
+
 XByteArray & QHexEditPrivate::xData()
 {
     return _xData;
@@ -110,9 +189,9 @@ XByteArray & QHexEditPrivate::xData()
 
 int QHexEditPrivate::indexOf(const QByteArray & ba, int from)
 {
-    if (from > (_xData.data().length() - 1))
-        from = _xData.data().length() - 1;
-    int idx = _xData.data().indexOf(ba, from);
+    if (from > (_xData.size() - 1))
+        from = _xData.size() - 1;
+    int idx = _xData.indexOf(SearchPattern(ba), from);
     if (idx > -1)
     {
         int curPos = idx*2;
@@ -124,30 +203,67 @@ int QHexEditPrivate::indexOf(const QByteArray & ba, int from)
     return idx;
 }
 
+bool QHexEditPrivate::setSearchPattern(const QString & pattern)
+{
+    bool ok;
+    SearchPattern searchPattern = SearchPattern::fromString(pattern, &ok);
+    if (!ok)
+        return false;
+
+    _xData.setSearchPattern(searchPattern);
+    update();
+    return true;
+}
+
+QVector<int> QHexEditPrivate::searchMatches()
+{
+    return _xData.searchMatches();
+}
+
+int QHexEditPrivate::findNext(int from)
+{
+    const QVector<int> &matches = _xData.searchMatches();
+    if (matches.isEmpty())
+        return -1;
+
+    // the first match at or after from, wrapping around at the end
+    QVector<int>::const_iterator it = qLowerBound(matches.constBegin(), matches.constEnd(), from);
+    int idx = (it == matches.constEnd()) ? matches.first() : *it;
+
+    int curPos = idx*2;
+    setCursorPos(curPos);
+    resetSelection(curPos);
+    setSelection(curPos + _xData.searchPattern().size()*2);
+    ensureVisible();
+    return idx;
+}
+
 void QHexEditPrivate::insert(int index, const QByteArray & ba)
 {
     if (ba.length() > 0)
     {
         if (_overwriteMode)
         {
-            QUndoCommand *arrayCommand= new ArrayCommand(&_xData, ArrayCommand::replace, index, ba, ba.length());
+            HexCommand *arrayCommand = new ArrayCommand(&_xData, ArrayCommand::replace, index, ba, ba.length());
             _undoStack->push(arrayCommand);
             emit dataChanged();
         }
         else
         {
-            QUndoCommand *arrayCommand= new ArrayCommand(&_xData, ArrayCommand::insert, index, ba, ba.length());
+            HexCommand *arrayCommand = new ArrayCommand(&_xData, ArrayCommand::insert, index, ba, ba.length());
             _undoStack->push(arrayCommand);
             emit dataChanged();
         }
+        updateEdit(index, _overwriteMode ? ba.length() : 0, ba.length());
     }
 }
 
 void QHexEditPrivate::insert(int index, char ch)
 {
-    QUndoCommand *charCommand = new CharCommand(&_xData, CharCommand::insert, index, ch);
+    HexCommand *charCommand = new CharCommand(&_xData, CharCommand::insert, index, ch);
     _undoStack->push(charCommand);
     emit dataChanged();
+    updateEdit(index, 0, 1);
 }
 
 int QHexEditPrivate::lastIndexOf(const QByteArray & ba, int from)
@@ -155,7 +271,7 @@ int QHexEditPrivate::lastIndexOf(const QByteArray & ba, int from)
     from -= ba.length();
     if (from < 0)
         from = 0;
-    int idx = _xData.data().lastIndexOf(ba, from);
+    int idx = _xData.lastIndexOf(SearchPattern(ba), from);
     if (idx > -1)
     {
         int curPos = idx*2;
@@ -175,13 +291,13 @@ void QHexEditPrivate::remove(int index, int len)
         {
             if (_overwriteMode)
             {
-                QUndoCommand *charCommand = new CharCommand(&_xData, CharCommand::replace, index, char(0));
+                HexCommand *charCommand = new CharCommand(&_xData, CharCommand::replace, index, char(0));
                 _undoStack->push(charCommand);
                 emit dataChanged();
             }
             else
             {
-                QUndoCommand *charCommand = new CharCommand(&_xData, CharCommand::remove, index, char(0));
+                HexCommand *charCommand = new CharCommand(&_xData, CharCommand::remove, index, char(0));
                 _undoStack->push(charCommand);
                 emit dataChanged();
             }
@@ -191,42 +307,70 @@ void QHexEditPrivate::remove(int index, int len)
             QByteArray ba = QByteArray(len, char(0));
             if (_overwriteMode)
             {
-                QUndoCommand *arrayCommand = new ArrayCommand(&_xData, ArrayCommand::replace, index, ba, ba.length());
+                HexCommand *arrayCommand = new ArrayCommand(&_xData, ArrayCommand::replace, index, ba, ba.length());
                 _undoStack->push(arrayCommand);
                 emit dataChanged();
             }
             else
             {
-                QUndoCommand *arrayCommand= new ArrayCommand(&_xData, ArrayCommand::remove, index, ba, len);
+                HexCommand *arrayCommand = new ArrayCommand(&_xData, ArrayCommand::remove, index, ba, len);
                 _undoStack->push(arrayCommand);
                 emit dataChanged();
             }
         }
+        updateEdit(index, len, _overwriteMode ? len : 0);
     }
 }
 
 void QHexEditPrivate::replace(int index, char ch)
 {
-    QUndoCommand *charCommand = new CharCommand(&_xData, CharCommand::replace, index, ch);
+    HexCommand *charCommand = new CharCommand(&_xData, CharCommand::replace, index, ch);
     _undoStack->push(charCommand);
     resetSelection();
     emit dataChanged();
+    updateEdit(index, 1, 1);
 }
 
 void QHexEditPrivate::replace(int index, const QByteArray & ba)
 {
-    QUndoCommand *arrayCommand= new ArrayCommand(&_xData, ArrayCommand::replace, index, ba, ba.length());
+    HexCommand *arrayCommand = new ArrayCommand(&_xData, ArrayCommand::replace, index, ba, ba.length());
     _undoStack->push(arrayCommand);
     resetSelection();
     emit dataChanged();
+    updateEdit(index, ba.length(), ba.length());
 }
 
 void QHexEditPrivate::replace(int pos, int len, const QByteArray &after)
 {
-    QUndoCommand *arrayCommand= new ArrayCommand(&_xData, ArrayCommand::replace, pos, after, len);
+    HexCommand *arrayCommand = new ArrayCommand(&_xData, ArrayCommand::replace, pos, after, len);
     _undoStack->push(arrayCommand);
     resetSelection();
     emit dataChanged();
+    updateEdit(pos, len, after.length());
+}
+
+void QHexEditPrivate::setDataChanged(int pos, int len, bool changed)
+{
+    if (pos < 0)
+    {
+        len += pos;
+        pos = 0;
+    }
+    if (len > 0 && pos < _xData.size())
+    {
+        _xData.setDataChanged(pos, len, changed);
+        updateBytes(pos, len);
+    }
+}
+
+int QHexEditPrivate::indexOfChanged(int from, int *length)
+{
+    int pos = _xData.nextChanged(qMax(0, from));
+    if (pos >= _xData.size())
+        return -1;
+    if (length)
+        *length = _xData.nextUnchanged(pos) - pos;
+    return pos;
 }
 
 void QHexEditPrivate::setAddressArea(bool addressArea)
@@ -250,9 +394,17 @@ void QHexEditPrivate::setAsciiArea(bool asciiArea)
     adjust();
 }
 
+void QHexEditPrivate::setWordDecoder(WordDecoder decoder, int width)
+{
+    _wordDecoder = (width > 0) ? decoder : 0;
+    _wordWidth = width;
+    adjust();
+}
+
 void QHexEditPrivate::setFont(const QFont &font)
 {
     QWidget::setFont(font);
+    updateGlyphCache();
     adjust();
 }
 
@@ -275,6 +427,7 @@ bool QHexEditPrivate::overwriteMode()
 void QHexEditPrivate::redo()
 {
     _undoStack->redo();
+    _wordLines.clear();
     emit dataChanged();
     setCursorPos(_cursorPosition);
     update();
@@ -283,11 +436,22 @@ void QHexEditPrivate::redo()
 void QHexEditPrivate::undo()
 {
     _undoStack->undo();
+    _wordLines.clear();
     emit dataChanged();
     setCursorPos(_cursorPosition);
     update();
 }
 
+void QHexEditPrivate::setUndoMemoryLimit(int bytes)
+{
+    _undoStack->setMemoryLimit(bytes);
+}
+
+int QHexEditPrivate::undoMemoryLimit()
+{
+    return _undoStack->memoryLimit();
+}
+
 QString QHexEditPrivate::toRedableString()
 {
     return _xData.toRedableString();
@@ -299,11 +463,21 @@ QString QHexEditPrivate::selectionToReadableString()
     return _xData.toRedableString(getSelectionBegin(), getSelectionEnd());
 }
 
+bool QHexEditPrivate::writeReadableString(QIODevice *device)
+{
+    return _xData.writeReadableString(device);
+}
+
+bool QHexEditPrivate::writeSelectionReadableString(QIODevice *device)
+{
+    return _xData.writeReadableString(device, getSelectionBegin(), getSelectionEnd());
+}
+
 void QHexEditPrivate::keyPressEvent(QKeyEvent *event)
 {
     int charX = (_cursorX - _xPosHex) / _charWidth;
     int posX = (charX / 3) * 2 + (charX % 3);
-    int posBa = (_cursorY / _charHeight) * BYTES_PER_LINE + posX / 2;
+    int posBa = _cursorPosition / 2;
 
 
 /*****************************************************************************/
@@ -459,7 +633,7 @@ if (!_readOnly)
             // Change content
             if (_xData.size() > 0)
             {
-                QByteArray hexValue = _xData.data().mid(posBa, 1).toHex();
+                QByteArray hexValue = _xData.mid(posBa, 1).toHex();
                 if ((charX % 3) == 0)
                     hexValue[0] = key;
                 else
@@ -478,7 +652,7 @@ if (!_readOnly)
             QString result = QString();
             for (int idx = getSelectionBegin(); idx < getSelectionEnd(); idx++)
             {
-                result += _xData.data().mid(idx, 1).toHex() + " ";
+                result += _xData.mid(idx, 1).toHex() + " ";
                 if ((idx % 16) == 15)
                     result.append("\n");
             }
@@ -560,7 +734,7 @@ if (!_readOnly)
         QString result = QString();
         for (int idx = getSelectionBegin(); idx < getSelectionEnd(); idx++)
         {
-            result += _xData.data().mid(idx, 1).toHex() + " ";
+            result += _xData.mid(idx, 1).toHex() + " ";
             if ((idx % 16) == 15)
                 result.append('\n');
         }
@@ -577,13 +751,12 @@ if (!_readOnly)
     }
 
     ensureVisible();
-    update();
 }
 
 void QHexEditPrivate::mouseMoveEvent(QMouseEvent * event)
 {
     _blink = false;
-    update();
+    update(cursorRect());
     int actPos = cursorPos(event->pos());
     setCursorPos(actPos);
     setSelection(actPos);
@@ -592,136 +765,195 @@ void QHexEditPrivate::mouseMoveEvent(QMouseEvent * event)
 void QHexEditPrivate::mousePressEvent(QMouseEvent * event)
 {
     _blink = false;
-    update();
+    update(cursorRect());
     int cPos = cursorPos(event->pos());
     resetSelection(cPos);
     setCursorPos(cPos);
 }
 
+void QHexEditPrivate::resizeEvent(QResizeEvent *)
+{
+    adjustScrollBars();
+}
+
 void QHexEditPrivate::paintEvent(QPaintEvent *event)
 {
+#ifdef QHEXEDIT_PAINT_BENCHMARK
+    QElapsedTimer paintTimer;
+    paintTimer.start();
+#endif
+
     QPainter painter(this);
 
     // draw some patterns if needed
     painter.fillRect(event->rect(), this->palette().color(QPalette::Base));
 
+    // only the rows inside the viewport are painted; x-coordinates below
+    // are content coordinates, y-coordinates are viewport coordinates
+    int xOffset = _scrollArea->horizontalScrollBar()->value();
+    QRect rect = event->rect().translated(xOffset, 0);
+    painter.translate(-xOffset, 0);
+
     // highlight 4-byte groups with different background color
     // TODO compute these coordinates properly
-    painter.fillRect(QRect(0, event->rect().top(),  11.5 * _charWidth, height()), _addressAreaColor);
-    painter.fillRect(QRect(23.5 * _charWidth, event->rect().top(),  12 * _charWidth, height()), _addressAreaColor);
+    painter.fillRect(QRect(0, rect.top(),  11.5 * _charWidth, height()), _addressAreaColor);
+    painter.fillRect(QRect(23.5 * _charWidth, rect.top(),  12 * _charWidth, height()), _addressAreaColor);
 
     if (_addressArea)
-        painter.fillRect(QRect(_xPosAdr, event->rect().top(), _xPosHex - GAP_ADR_HEX + 2, height()), _addressAreaColor);
+        painter.fillRect(QRect(_xPosAdr, rect.top(), _xPosHex - GAP_ADR_HEX + 2, height()), _addressAreaColor);
     if (_asciiArea)
     {
         int linePos = _xPosAscii - (GAP_HEX_ASCII / 2);
         painter.setPen(Qt::gray);
-        painter.drawLine(linePos, event->rect().top(), linePos, height());
+        painter.drawLine(linePos, rect.top(), linePos, height());
     }
 
     painter.setPen(this->palette().color(QPalette::WindowText));
 
-    // calc position
-    int firstLineIdx = ((event->rect().top()/ _charHeight) - _charHeight) * BYTES_PER_LINE;
-    if (firstLineIdx < 0)
-        firstLineIdx = 0;
-    int lastLineIdx = ((event->rect().bottom() / _charHeight) + _charHeight) * BYTES_PER_LINE;
-    if (lastLineIdx > _xData.size())
-        lastLineIdx = _xData.size();
-    int yPosStart = ((firstLineIdx) / BYTES_PER_LINE) * _charHeight + _charHeight;
+    // calc position, in 64 bit since the line after the last one may lie
+    // beyond the int range; text rows straddle the charHeight grid, so one
+    // extra row is painted on either side
+    int firstRow = qMax(0, rect.top() / _charHeight - 1);
+    int lastRow = rect.bottom() / _charHeight + 1;
+    qint64 firstLine = firstVisibleLine() + firstRow;
+    int firstLineIdx = (int) qMin<qint64>(firstLine * BYTES_PER_LINE, _xData.size());
+    int lastLineIdx = (int) qMin<qint64>((firstLine + lastRow - firstRow + 1) * BYTES_PER_LINE, _xData.size());
+    int yPosStart = firstRow * _charHeight + _charHeight;
+
+    // partial updates (cursor, edits, selection) only expose a few rows,
+    // the others are skipped instead of being painted and clipped away
+    QRegion exposed = event->region();
 
     // paint address area
     if (_addressArea)
     {
         for (int lineIdx = firstLineIdx, yPos = yPosStart; lineIdx < lastLineIdx; lineIdx += BYTES_PER_LINE, yPos +=_charHeight)
         {
+            if (!exposed.intersects(QRect(0, yPos - _charAscent, width(), _charHeight)))
+                continue;
             QString address = QString("%1")
                               .arg(lineIdx + _xData.addressOffset(), _xData.realAddressNumbers(), 16, QChar('0'));
             painter.drawText(_xPosAdr, yPos, address);
         }
     }
 
-    // paint hex area
-    QByteArray hexBa(_xData.data().mid(firstLineIdx, lastLineIdx - firstLineIdx + 1).toHex());
-    QBrush highLighted = QBrush(_highlightingColor);
-    QPen colHighlighted = QPen(this->palette().color(QPalette::WindowText));
-    QBrush selected = QBrush(_selectionColor);
-    QPen colSelected = QPen(Qt::white);
-    QPen colStandard = QPen(this->palette().color(QPalette::WindowText));
+    // paint hex area, one run of identically styled bytes at a time
+    // only the visible bytes are fetched, the data is not made contiguous
+    QByteArray visible = _xData.mid(firstLineIdx, lastLineIdx - firstLineIdx);
+    const char *bytes = visible.constData();
+
+    // mark the bytes covered by search matches overlapping the visible ones
+    QByteArray matched(lastLineIdx - firstLineIdx, char(0));
+    const QVector<int> &matches = _xData.searchMatches();
+    int patternSize = _xData.searchPattern().size();
+    QVector<int>::const_iterator match = qLowerBound(matches.constBegin(), matches.constEnd(), firstLineIdx - patternSize + 1);
+    for (; (match != matches.constEnd()) && (*match < lastLineIdx); ++match)
+    {
+        for (int pos = qMax(*match, firstLineIdx); pos < qMin(*match + patternSize, lastLineIdx); pos++)
+            matched[pos - firstLineIdx] = 1;
+    }
 
-    painter.setBackgroundMode(Qt::TransparentMode);
+    int selBegin = getSelectionBegin();
+    int selEnd = getSelectionEnd();
+    QColor colStandard = this->palette().color(QPalette::WindowText);
 
     for (int lineIdx = firstLineIdx, yPos = yPosStart; lineIdx < lastLineIdx; lineIdx += BYTES_PER_LINE, yPos +=_charHeight)
     {
-        QByteArray hex;
-        int xPos = _xPosHex;
-        for (int colIdx = 0; ((lineIdx + colIdx) < _xData.size() and (colIdx < BYTES_PER_LINE)); colIdx++)
+        int lineLen = qMin(BYTES_PER_LINE, lastLineIdx - lineIdx);
+        int textTop = yPos - _charAscent;
+        if (!exposed.intersects(QRect(0, textTop, width(), _charHeight)))
+            continue;
+        ByteStyle styles[BYTES_PER_LINE];
+        for (int colIdx = 0; colIdx < lineLen; colIdx++)
+            styles[colIdx] = byteStyle(lineIdx + colIdx, selBegin, selEnd, _xData.dataChanged(lineIdx + colIdx),
+                                       matched.at(lineIdx - firstLineIdx + colIdx));
+
+        int runStart = 0;
+        while (runStart < lineLen)
         {
-            int posBa = lineIdx + colIdx;
-            if ((getSelectionBegin() <= posBa) && (getSelectionEnd() > posBa))
-            {
-                painter.setBackground(selected);
-                painter.setBackgroundMode(Qt::OpaqueMode);
-                painter.setPen(colSelected);
-            }
-            else
-            {
-                if (_highlighting)
-                {
-                    // hilight diff bytes
-                    painter.setBackground(highLighted);
-                    if (_xData.dataChanged(posBa))
-                    {
-                        painter.setPen(colHighlighted);
-                        painter.setBackgroundMode(Qt::OpaqueMode);
-                    }
-                    else
-                    {
-                        painter.setPen(colStandard);
-                        painter.setBackgroundMode(Qt::TransparentMode);
-                    }
-                }
-            }
+            ByteStyle style = styles[runStart];
+            int runEnd = runStart + 1;
+            while ((runEnd < lineLen) && (styles[runEnd] == style))
+                runEnd++;
 
-            // render hex value
-            if (colIdx == 0)
+            // the background of a byte covers the space in front of it
+            if (style != StandardByte)
             {
-                hex = hexBa.mid((lineIdx - firstLineIdx) * 2, 2);
-                painter.drawText(xPos, yPos, hex);
-                xPos += 2 * _charWidth;
-            } else {
-                hex = hexBa.mid((lineIdx + colIdx - firstLineIdx) * 2, 2).prepend(" ");
-                painter.drawText(xPos, yPos, hex);
-                xPos += 3 * _charWidth;
+                int left = _xPosHex + (runStart == 0 ? 0 : (3 * runStart - 1) * _charWidth);
+                int right = _xPosHex + (3 * (runEnd - 1) + 2) * _charWidth;
+                QColor background = _highlightingColor;
+                if (style == SelectedByte)
+                    background = _selectionColor;
+                else if (style == MatchedByte)
+                    background = _searchColor;
+                painter.fillRect(left, textTop, right - left, _charHeight, background);
             }
 
+            painter.setPen(style == SelectedByte ? QColor(Qt::white) : colStandard);
+            for (int colIdx = runStart; colIdx < runEnd; colIdx++)
+                painter.drawStaticText(_xPosHex + 3 * colIdx * _charWidth, textTop,
+                                       _hexGlyphs[(uchar) bytes[lineIdx - firstLineIdx + colIdx]]);
+
+            runStart = runEnd;
         }
     }
-    painter.setBackgroundMode(Qt::TransparentMode);
-    painter.setPen(this->palette().color(QPalette::WindowText));
+    painter.setPen(colStandard);
 
     // paint ascii area
     if (_asciiArea)
     {
         for (int lineIdx = firstLineIdx, yPos = yPosStart; lineIdx < lastLineIdx; lineIdx += BYTES_PER_LINE, yPos +=_charHeight)
         {
-            int xPosAscii = _xPosAscii;
-            for (int colIdx = 0; ((lineIdx + colIdx) < _xData.size() and (colIdx < BYTES_PER_LINE)); colIdx++)
-            {
-                painter.drawText(xPosAscii, yPos, _xData.asciiChar(lineIdx + colIdx));
-                xPosAscii += _charWidth;
-            }
+            if (!exposed.intersects(QRect(0, yPos - _charAscent, width(), _charHeight)))
+                continue;
+            int lineLen = qMin(BYTES_PER_LINE, lastLineIdx - lineIdx);
+            for (int colIdx = 0; colIdx < lineLen; colIdx++)
+                painter.drawStaticText(_xPosAscii + colIdx * _charWidth, yPos - _charAscent,
+                                       _asciiGlyphs[(uchar) bytes[lineIdx - firstLineIdx + colIdx]]);
+        }
+    }
+
+    // paint word area, each line is decoded once and then taken from the cache
+    if (_wordDecoder)
+    {
+        int linePos = _xPosWords - (GAP_HEX_ASCII / 2);
+        painter.setPen(Qt::gray);
+        painter.drawLine(linePos, rect.top(), linePos, height());
+        painter.setPen(colStandard);
+
+        for (int lineIdx = firstLineIdx, yPos = yPosStart; lineIdx < lastLineIdx; lineIdx += BYTES_PER_LINE, yPos +=_charHeight)
+        {
+            if (!exposed.intersects(QRect(0, yPos - _charAscent, width(), _charHeight)))
+                continue;
+            int lineLen = qMin(BYTES_PER_LINE, lastLineIdx - lineIdx);
+            painter.drawStaticText(_xPosWords, yPos - _charAscent,
+                                   *wordLine(lineIdx, bytes + (lineIdx - firstLineIdx), lineLen));
         }
     }
 
     // paint cursor
     if (_blink && !_readOnly && hasFocus())
     {
+        painter.resetTransform();
+        QRect cursor = cursorRect();
         if (_overwriteMode)
-            painter.fillRect(_cursorX, _cursorY + _charHeight - 2, _charWidth, 2, this->palette().color(QPalette::WindowText));
+            painter.fillRect(cursor.x(), cursor.y() + _charHeight - 2, _charWidth, 2, this->palette().color(QPalette::WindowText));
         else
-            painter.fillRect(_cursorX, _cursorY, 2, _charHeight, this->palette().color(QPalette::WindowText));
+            painter.fillRect(cursor.x(), cursor.y(), 2, _charHeight, this->palette().color(QPalette::WindowText));
+    }
+
+#ifdef QHEXEDIT_PAINT_BENCHMARK
+    // report the average paint time every PAINT_BENCHMARK_FRAMES frames
+    painter.end();
+    _paintTime += paintTimer.nsecsElapsed();
+    if (++_paintFrames == PAINT_BENCHMARK_FRAMES)
+    {
+        qDebug() << "QHexEdit paint:" << _paintTime / _paintFrames / 1000 << "us per frame,"
+                 << (lastLineIdx - firstLineIdx) << "bytes in the last frame";
+        _paintTime = 0;
+        _paintFrames = 0;
     }
+#endif
 
     if (_size != _xData.size())
     {
@@ -730,11 +962,73 @@ void QHexEditPrivate::paintEvent(QPaintEvent *event)
     }
 }
 
+QHexEditPrivate::ByteStyle QHexEditPrivate::byteStyle(int pos, int selBegin, int selEnd, bool changed, bool matched)
+{
+    if ((selBegin <= pos) && (selEnd > pos))
+        return SelectedByte;
+    if (matched)
+        return MatchedByte;
+    if (_highlighting && changed)
+        return ChangedByte;
+    return StandardByte;
+}
+
+void QHexEditPrivate::updateGlyphCache()
+{
+    // every byte value is laid out once per font, so painting only has to
+    // blit the prepared glyphs
+    for (int i = 0; i < 256; i++)
+    {
+        char ch = char(i);
+        if ((ch < 0x20) or (ch > 0x7e))
+            ch = '.';
+
+        _hexGlyphs[i].setText(QString("%1").arg(i, 2, 16, QChar('0')));
+        _asciiGlyphs[i].setText(QString(QChar(ch)));
+
+        _hexGlyphs[i].setTextFormat(Qt::PlainText);
+        _asciiGlyphs[i].setTextFormat(Qt::PlainText);
+        _hexGlyphs[i].setPerformanceHint(QStaticText::AggressiveCaching);
+        _asciiGlyphs[i].setPerformanceHint(QStaticText::AggressiveCaching);
+        _hexGlyphs[i].prepare(QTransform(), font());
+        _asciiGlyphs[i].prepare(QTransform(), font());
+    }
+}
+
+QStaticText *QHexEditPrivate::wordLine(int lineIdx, const char *bytes, int len)
+{
+    QStaticText *text = _wordLines.object(lineIdx / BYTES_PER_LINE);
+    if (text)
+        return text;
+
+    // words are little-endian, a word cut off by the end of the data is left out
+    QString line;
+    for (int word = 0; (word + 1) * 4 <= len; word++)
+    {
+        const uchar *p = (const uchar *) bytes + 4 * word;
+        quint32 value = p[0] | (p[1] << 8) | (p[2] << 16) | (quint32(p[3]) << 24);
+        if (word > 0)
+            line += "  ";
+
+        // decodes that do not fit are cut visibly
+        QString decoded = _wordDecoder(value, _xData.addressOffset() + lineIdx + 4 * word);
+        if (decoded.length() > _wordWidth)
+            decoded = decoded.left(_wordWidth - 1) + QChar(0x2026);
+        line += decoded.leftJustified(_wordWidth, ' ');
+    }
+
+    text = new QStaticText(line);
+    text->setTextFormat(Qt::PlainText);
+    text->prepare(QTransform(), font());
+    _wordLines.insert(lineIdx / BYTES_PER_LINE, text);
+    return text;
+}
+
 void QHexEditPrivate::setCursorPos(int position)
 {
     // delete cursor
     _blink = false;
-    update();
+    update(cursorRect());
 
     // cursor in range?
     if (_overwriteMode)
@@ -751,28 +1045,29 @@ void QHexEditPrivate::setCursorPos(int position)
 
     // calc position
     _cursorPosition = position;
-    _cursorY = (position / (2 * BYTES_PER_LINE)) * _charHeight + 4;
+    _cursorLine = position / (2 * BYTES_PER_LINE);
     int x = (position % (2 * BYTES_PER_LINE));
     _cursorX = (((x / 2) * 3) + (x % 2)) * _charWidth + _xPosHex;
 
     // immiadately draw cursor
     _blink = true;
-    update();
+    update(cursorRect());
     emit currentAddressChanged(_cursorPosition/2);
 }
 
 int QHexEditPrivate::cursorPos(QPoint pos)
 {
     int result = -1;
+    int xPos = pos.x() + _scrollArea->horizontalScrollBar()->value();
     // find char under cursor
-    if ((pos.x() >= _xPosHex) and (pos.x() < (_xPosHex + HEXCHARS_IN_LINE * _charWidth)))
+    if ((xPos >= _xPosHex) and (xPos < (_xPosHex + HEXCHARS_IN_LINE * _charWidth)))
     {
-        int x = (pos.x() - _xPosHex) / _charWidth;
+        int x = (xPos - _xPosHex) / _charWidth;
         if ((x % 3) == 0)
             x = (x / 3) * 2;
         else
             x = ((x / 3) * 2) + 1;
-        int y = ((pos.y() - 3) / _charHeight) * 2 * BYTES_PER_LINE;
+        int y = (firstVisibleLine() + (pos.y() - 3) / _charHeight) * 2 * BYTES_PER_LINE;
         result = x + y;
     }
     return result;
@@ -785,8 +1080,11 @@ int QHexEditPrivate::cursorPos()
 
 void QHexEditPrivate::resetSelection()
 {
+    int oldBegin = _selectionBegin;
+    int oldEnd = _selectionEnd;
     _selectionBegin = _selectionInit;
     _selectionEnd = _selectionInit;
+    updateSelection(oldBegin, oldEnd);
 }
 
 void QHexEditPrivate::resetSelection(int pos)
@@ -794,9 +1092,12 @@ void QHexEditPrivate::resetSelection(int pos)
     if (pos < 0)
         pos = 0;
     pos = pos / 2;
+    int oldBegin = _selectionBegin;
+    int oldEnd = _selectionEnd;
     _selectionInit = pos;
     _selectionBegin = pos;
     _selectionEnd = pos;
+    updateSelection(oldBegin, oldEnd);
 }
 
 void QHexEditPrivate::setSelection(int pos)
@@ -804,6 +1105,8 @@ void QHexEditPrivate::setSelection(int pos)
     if (pos < 0)
         pos = 0;
     pos = pos / 2;
+    int oldBegin = _selectionBegin;
+    int oldEnd = _selectionEnd;
     if (pos >= _selectionInit)
     {
         _selectionEnd = pos;
@@ -814,6 +1117,7 @@ void QHexEditPrivate::setSelection(int pos)
         _selectionBegin = pos;
         _selectionEnd = _selectionInit;
     }
+    updateSelection(oldBegin, oldEnd);
 }
 
 int QHexEditPrivate::getSelectionBegin()
@@ -833,13 +1137,14 @@ void QHexEditPrivate::updateCursor()
         _blink = false;
     else
         _blink = true;
-    update(_cursorX, _cursorY, _charWidth, _charHeight);
+    update(cursorRect());
 }
 
 void QHexEditPrivate::adjust()
 {
     _charWidth = fontMetrics().width(QLatin1Char('9'));
     _charHeight = fontMetrics().height();
+    _charAscent = fontMetrics().ascent();
 
     _xPosAdr = 0;
     if (_addressArea)
@@ -848,19 +1153,151 @@ void QHexEditPrivate::adjust()
         _xPosHex = 0;
     _xPosAscii = _xPosHex + HEXCHARS_IN_LINE * _charWidth + GAP_HEX_ASCII;
 
-    // tell QAbstractScollbar, how big we are
-    setMinimumHeight(((_xData.size()/16 + 1) * _charHeight) + 5);
     if(_asciiArea)
-        setMinimumWidth(_xPosAscii + (BYTES_PER_LINE * _charWidth));
+        _contentWidth = _xPosAscii + (BYTES_PER_LINE * _charWidth);
     else
-        setMinimumWidth(_xPosHex + HEXCHARS_IN_LINE * _charWidth);
+        _contentWidth = _xPosHex + HEXCHARS_IN_LINE * _charWidth;
 
+    // the word area follows the last of the other areas
+    _xPosWords = _contentWidth + GAP_HEX_ASCII;
+    if (_wordDecoder)
+        _contentWidth = _xPosWords + (WORDS_PER_LINE * (_wordWidth + 2) - 2) * _charWidth;
+
+    // addresses or the font may have changed
+    _wordLines.clear();
+
+    adjustScrollBars();
     update();
 }
 
+void QHexEditPrivate::adjustScrollBars()
+{
+    // the vertical scroll bar counts lines, not pixels, so that the range
+    // stays small for any size of data
+    int lines = _xData.size() / BYTES_PER_LINE + 1;
+    QScrollBar *vBar = _scrollArea->verticalScrollBar();
+    vBar->setRange(0, qMax(0, lines - visibleLines()));
+    vBar->setPageStep(visibleLines());
+    vBar->setSingleStep(1);
+
+    QScrollBar *hBar = _scrollArea->horizontalScrollBar();
+    hBar->setRange(0, qMax(0, _contentWidth - width()));
+    hBar->setPageStep(width());
+    hBar->setSingleStep(_charWidth);
+}
+
 void QHexEditPrivate::ensureVisible()
 {
-    // scrolls to cursorx, cusory (which are set by setCursorPos)
-    // x-margin is 3 pixels, y-margin is half of charHeight
-    _scrollArea->ensureVisible(_cursorX, _cursorY + _charHeight/2, 3, _charHeight/2 + 2);
+    // scrolls to the cursor (which is set by setCursorPos)
+    // x-margin is 3 pixels
+    QScrollBar *vBar = _scrollArea->verticalScrollBar();
+    if (_cursorLine < vBar->value())
+        vBar->setValue(_cursorLine);
+    else if (_cursorLine >= vBar->value() + visibleLines())
+        vBar->setValue(_cursorLine - visibleLines() + 1);
+
+    QScrollBar *hBar = _scrollArea->horizontalScrollBar();
+    if (_cursorX - 3 < hBar->value())
+        hBar->setValue(_cursorX - 3);
+    else if (_cursorX + _charWidth + 3 > hBar->value() + width())
+        hBar->setValue(_cursorX + _charWidth + 3 - width());
+}
+
+int QHexEditPrivate::firstVisibleLine()
+{
+    return _scrollArea->verticalScrollBar()->value();
+}
+
+int QHexEditPrivate::visibleLines()
+{
+    return qMax(1, height() / _charHeight);
+}
+
+QRect QHexEditPrivate::cursorRect()
+{
+    int x = _cursorX - _scrollArea->horizontalScrollBar()->value();
+    int y = (_cursorLine - firstVisibleLine()) * _charHeight + 4;
+    return QRect(x, y, _charWidth, _charHeight);
+}
+
+void QHexEditPrivate::updateBytes(int pos, int len)
+{
+    // clipped to the visible lines and the padding line painted on either side
+    qint64 first = qMax<qint64>(pos, qint64(firstVisibleLine() - 1) * BYTES_PER_LINE);
+    qint64 end = qMin<qint64>(qint64(pos) + len, qint64(firstVisibleLine() + visibleLines() + 2) * BYTES_PER_LINE);
+    if (first >= end)
+        return;
+
+    int firstLine = first / BYTES_PER_LINE;
+    int lastLine = (end - 1) / BYTES_PER_LINE;
+    int firstCol = first % BYTES_PER_LINE;
+    int endCol = (end - 1) % BYTES_PER_LINE + 1;
+
+    if (firstLine == lastLine)
+    {
+        updateLines(firstLine, firstLine + 1, firstCol, endCol);
+        return;
+    }
+    updateLines(firstLine, firstLine + 1, firstCol, BYTES_PER_LINE);
+    if (lastLine > firstLine + 1)
+        updateLines(firstLine + 1, lastLine, 0, BYTES_PER_LINE);
+    updateLines(lastLine, lastLine + 1, 0, endCol);
+}
+
+void QHexEditPrivate::updateLines(int firstLine, int endLine, int firstCol, int endCol)
+{
+    // same cells as painted by paintEvent, the background of a byte covers
+    // the space in front of it
+    int xOffset = _scrollArea->horizontalScrollBar()->value();
+    int top = (firstLine - firstVisibleLine() + 1) * _charHeight - _charAscent;
+    int height = (endLine - firstLine) * _charHeight;
+
+    int left = _xPosHex + (firstCol == 0 ? 0 : (3 * firstCol - 1) * _charWidth);
+    int right = _xPosHex + (3 * endCol - 1) * _charWidth;
+    update(left - xOffset, top, right - left, height);
+
+    if (_asciiArea)
+        update(_xPosAscii + firstCol * _charWidth - xOffset, top, (endCol - firstCol) * _charWidth, height);
+    if (_wordDecoder)
+        update(_xPosWords - xOffset, top, _contentWidth - _xPosWords, height);
+}
+
+void QHexEditPrivate::updateEdit(int pos, int oldLen, int newLen)
+{
+    // matches of the search pattern reaching into the edit may change, and
+    // when the size changes all following bytes move
+    int margin = qMax(0, _xData.searchPattern().size() - 1);
+    if (oldLen == newLen)
+        updateBytes(pos - margin, newLen + 2 * margin);
+    else
+    {
+        adjustScrollBars();
+        updateBytes(pos - margin, INT_MAX);
+    }
+
+    // only the decoded lines of changed bytes are dropped, unless bytes move
+    int firstLine = pos / BYTES_PER_LINE;
+    int lastLine = (pos + qMax(newLen, 1) - 1) / BYTES_PER_LINE;
+    if ((oldLen != newLen) || (lastLine - firstLine >= WORD_CACHE_LINES))
+        _wordLines.clear();
+    else
+    {
+        for (int line = firstLine; line <= lastLine; line++)
+            _wordLines.remove(line);
+    }
+}
+
+void QHexEditPrivate::updateSelection(int oldBegin, int oldEnd)
+{
+    // only the bytes entering or leaving the selection change
+    if ((oldEnd <= _selectionBegin) || (_selectionEnd <= oldBegin))
+    {
+        updateBytes(oldBegin, oldEnd - oldBegin);
+        updateBytes(_selectionBegin, _selectionEnd - _selectionBegin);
+    }
+    else
+    {
+        updateBytes(qMin(oldBegin, _selectionBegin), qAbs(oldBegin - _selectionBegin));
+        updateBytes(qMin(oldEnd, _selectionEnd), qAbs(oldEnd - _selectionEnd));
+    }
 }
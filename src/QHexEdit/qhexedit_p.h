@@ -6,16 +6,20 @@
 
 #include <QtGui>
 #include <QWidget>
-#include <QScrollArea>
-#include <QUndoStack>
+#include <QAbstractScrollArea>
+#include <QScrollBar>
+#include "undostack.h"
 #include "xbytearray.h"
 
+// decodes the 32 bit word at address (content address, including the address offset)
+typedef QString (*WordDecoder)(quint32 word, int address);
+
 class QHexEditPrivate : public QWidget
 {
 Q_OBJECT
 
 public:
-    QHexEditPrivate(QScrollArea *parent);
+    QHexEditPrivate(QAbstractScrollArea *parent);
 
     void setAddressAreaColor(QColor const &color);
     QColor addressAreaColor();
@@ -28,6 +32,12 @@ public:
 
     void setData(QByteArray const &data);
     QByteArray data();
+    QByteArray dataAt(int pos, int len);
+    const char *constData();
+    int dataSize();
+    int read(int pos, int len, char *dest);
+    bool openFile(const QString &fileName);
+    bool saveFile(const QString &fileName);
 
     void setHighlightingColor(QColor const &color);
     QColor highlightingColor();
@@ -41,9 +51,15 @@ public:
     void setSelectionColor(QColor const &color);
     QColor selectionColor();
 
+    void setSearchColor(QColor const &color);
+    QColor searchColor();
+
     XByteArray & xData();
 
     int indexOf(const QByteArray & ba, int from = 0);
+    bool setSearchPattern(const QString & pattern);
+    QVector<int> searchMatches();
+    int findNext(int from);
     void insert(int index, const QByteArray & ba);
     void insert(int index, char ch);
     int lastIndexOf(const QByteArray & ba, int from = 0);
@@ -51,18 +67,25 @@ public:
     void replace(int index, char ch);
     void replace(int index, const QByteArray & ba);
     void replace(int pos, int len, const QByteArray & after);
+    void setDataChanged(int pos, int len, bool changed);
+    int indexOfChanged(int from, int *length);
 
     void setAddressArea(bool addressArea);
     void setAddressWidth(int addressWidth);
     void setAsciiArea(bool asciiArea);
+    void setWordDecoder(WordDecoder decoder, int width);
     void setHighlighting(bool mode);
     virtual void setFont(const QFont &font);
 
     void undo();
     void redo();
+    void setUndoMemoryLimit(int bytes);
+    int undoMemoryLimit();
 
     QString toRedableString();
     QString selectionToReadableString();
+    bool writeReadableString(QIODevice *device);
+    bool writeSelectionReadableString(QIODevice *device);
 
 signals:
     void currentAddressChanged(int address);
@@ -76,6 +99,7 @@ protected:
     void mousePressEvent(QMouseEvent * event);
 
     void paintEvent(QPaintEvent *event);
+    void resizeEvent(QResizeEvent *event);
 
     int cursorPos(QPoint pos);          // calc cursorpos from graphics position. DOES NOT STORE POSITION
 
@@ -90,15 +114,29 @@ private slots:
     void updateCursor();
 
 private:
+    enum ByteStyle { StandardByte, ChangedByte, MatchedByte, SelectedByte };
+
     void adjust();
+    void adjustScrollBars();
     void ensureVisible();
+    int firstVisibleLine();             // logical line shown at the top of the viewport
+    int visibleLines();                 // number of lines fitting into the viewport
+    QRect cursorRect();                 // cursor cell in viewport coordinates
+    void updateBytes(int pos, int len);     // repaint only these bytes, as far as visible
+    void updateLines(int firstLine, int endLine, int firstCol, int endCol);
+    void updateEdit(int pos, int oldLen, int newLen);   // oldLen bytes at pos became newLen bytes
+    void updateSelection(int oldBegin, int oldEnd);
+    ByteStyle byteStyle(int pos, int selBegin, int selEnd, bool changed, bool matched);
+    void updateGlyphCache();
+    QStaticText *wordLine(int lineIdx, const char *bytes, int len);
 
     QColor _addressAreaColor;
     QColor _highlightingColor;
+    QColor _searchColor;
     QColor _selectionColor;
-    QScrollArea *_scrollArea;
+    QAbstractScrollArea *_scrollArea;
     QTimer _cursorTimer;
-    QUndoStack *_undoStack;
+    UndoStack *_undoStack;
 
     XByteArray _xData;                      // Hält den Inhalt des Hex Editors
 
@@ -111,15 +149,30 @@ private:
     bool _readOnly;                         // true: the user can only look and navigate
 
     int _charWidth, _charHeight;            // char dimensions (dpendend on font)
-    int _cursorX, _cursorY;                 // graphics position of the cursor
+    int _charAscent;                        // distance from the top of a line to the baseline
+    int _cursorX;                           // graphics x-position of the cursor
+    int _cursorLine;                        // logical line of the cursor
     int _cursorPosition;                    // character positioin in stream (on byte ends in to steps)
-    int _xPosAdr, _xPosHex, _xPosAscii;     // graphics x-position of the areas
+    int _xPosAdr, _xPosHex, _xPosAscii, _xPosWords;     // graphics x-position of the areas
+    int _contentWidth;                      // width of all areas together
 
     int _selectionBegin;                    // First selected char
     int _selectionEnd;                      // Last selected char
     int _selectionInit;                     // That's, where we pressed the mouse button
 
     int _size;
+
+    QStaticText _hexGlyphs[256];            // pre-laid-out hex pair of every byte value
+    QStaticText _asciiGlyphs[256];          // pre-laid-out ascii char of every byte value
+
+    WordDecoder _wordDecoder;               // fills the word area, 0 if there is none
+    int _wordWidth;                         // chars per decoded word
+    QCache<int, QStaticText> _wordLines;    // decoded words by line, dropped when the line changes
+
+#ifdef QHEXEDIT_PAINT_BENCHMARK
+    qint64 _paintTime;                      // accumulated paint time in ns
+    int _paintFrames;
+#endif
 };
 
 /** \endcond docNever */
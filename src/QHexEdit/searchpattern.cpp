@@ -0,0 +1,111 @@
+#include "searchpattern.h"
+
+SearchPattern::SearchPattern()
+{
+    buildShiftTable();
+}
+
+SearchPattern::SearchPattern(const QByteArray &bytes)
+{
+    _bytes = bytes;
+    _mask = QByteArray(bytes.size(), char(0xff));
+    buildShiftTable();
+}
+
+SearchPattern SearchPattern::fromString(const QString &pattern, bool *ok)
+{
+    QString digits = pattern.simplified().remove(' ');
+    SearchPattern result;
+    bool valid = (digits.size() % 2) == 0;
+
+    for (int i = 0; valid && (i < digits.size()); i += 2)
+    {
+        uchar byte = 0;
+        uchar mask = 0;
+        for (int j = 0; j < 2; j++)
+        {
+            QChar c = digits.at(i + j);
+            if (c == QChar('?'))
+                continue;
+
+            int shift = (j == 0) ? 4 : 0;
+            bool isHex;
+            int value = QString(c).toInt(&isHex, 16);
+            if (!isHex)
+            {
+                valid = false;
+                break;
+            }
+            byte |= value << shift;
+            mask |= 0x0f << shift;
+        }
+        result._bytes.append(char(byte));
+        result._mask.append(char(mask));
+    }
+
+    if (!valid)
+        result = SearchPattern();
+    result.buildShiftTable();
+    if (ok)
+        *ok = valid;
+    return result;
+}
+
+bool SearchPattern::isEmpty() const
+{
+    return _bytes.isEmpty();
+}
+
+int SearchPattern::size() const
+{
+    return _bytes.size();
+}
+
+bool SearchPattern::matchesAt(const char *data) const
+{
+    const char *bytes = _bytes.constData();
+    const char *mask = _mask.constData();
+    for (int i = _bytes.size() - 1; i >= 0; i--)
+    {
+        if ((data[i] & mask[i]) != bytes[i])
+            return false;
+    }
+    return true;
+}
+
+QVector<int> SearchPattern::findAll(const char *data, int len) const
+{
+    QVector<int> result;
+    int m = _bytes.size();
+    if (m == 0)
+        return result;
+
+    int pos = 0;
+    while (pos + m <= len)
+    {
+        if (matchesAt(data + pos))
+            result.append(pos);
+        pos += _shift[(uchar) data[pos + m - 1]];
+    }
+    return result;
+}
+
+void SearchPattern::buildShiftTable()
+{
+    int m = _bytes.size();
+    for (int c = 0; c < 256; c++)
+        _shift[c] = qMax(m, 1);
+
+    // the shift for a byte value is the distance from the last pattern
+    // position accepting it to the end of the pattern
+    for (int i = 0; i < m - 1; i++)
+    {
+        uchar mask = _mask.at(i);
+        uchar byte = _bytes.at(i);
+        for (int c = 0; c < 256; c++)
+        {
+            if ((c & mask) == byte)
+                _shift[c] = m - 1 - i;
+        }
+    }
+}
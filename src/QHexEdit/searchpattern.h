@@ -0,0 +1,40 @@
+#ifndef SEARCHPATTERN_H
+#define SEARCHPATTERN_H
+
+/** \cond docNever */
+
+#include <QtCore>
+
+/*! SearchPattern is a byte pattern with a mask per byte, so that single
+nibbles or whole bytes can be wildcards, like the register fields of an
+instruction encoding. Patterns are written as hex digits, where '?' stands
+for any nibble, e.g. "3c ?? 0? 8f".
+
+Matches are found with Boyer-Moore-Horspool: the shift table is built from
+every byte value the masked pattern bytes accept, so a wildcard only shortens
+the shifts instead of forcing a compare at every position.
+*/
+class SearchPattern
+{
+public:
+    SearchPattern();
+    explicit SearchPattern(const QByteArray & bytes);      // exact pattern
+
+    static SearchPattern fromString(const QString & pattern, bool *ok = 0);
+
+    bool isEmpty() const;
+    int size() const;
+
+    bool matchesAt(const char *data) const;                // data holds size() bytes
+    QVector<int> findAll(const char *data, int len) const;
+
+private:
+    void buildShiftTable();
+
+    QByteArray _bytes;                      // already masked
+    QByteArray _mask;
+    int _shift[256];
+};
+
+/** \endcond docNever */
+#endif // SEARCHPATTERN_H
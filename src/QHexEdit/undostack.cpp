@@ -0,0 +1,116 @@
+#include "undostack.h"
+
+const int DEFAULT_MEMORY_LIMIT = 16 * 1024 * 1024;
+
+UndoStack::UndoStack(QObject *parent) : QObject(parent)
+{
+    _index = 0;
+    _memoryLimit = DEFAULT_MEMORY_LIMIT;
+    _memoryUsage = 0;
+}
+
+UndoStack::~UndoStack()
+{
+    clear();
+}
+
+void UndoStack::push(HexCommand *command)
+{
+    command->redo();
+
+    // the undone commands can't be redone anymore
+    while (_commands.size() > _index)
+    {
+        _memoryUsage -= _costs.takeLast();
+        delete _commands.takeLast();
+    }
+
+    HexCommand *top = _commands.isEmpty() ? 0 : _commands.last();
+    if (top && (command->id() != -1) && (top->id() == command->id()) && top->mergeWith(command))
+    {
+        delete command;
+        _memoryUsage -= _costs.last();
+        _costs.last() = top->memoryCost();
+        _memoryUsage += _costs.last();
+    }
+    else
+    {
+        _commands.append(command);
+        _costs.append(command->memoryCost());
+        _memoryUsage += _costs.last();
+        _index++;
+    }
+
+    enforceLimit();
+}
+
+void UndoStack::undo()
+{
+    if (_index == 0)
+        return;
+
+    _index--;
+    _commands.at(_index)->undo();
+}
+
+void UndoStack::redo()
+{
+    if (_index == _commands.size())
+        return;
+
+    // redoing captures the replaced bytes again, which may change the cost
+    HexCommand *command = _commands.at(_index);
+    command->redo();
+    _memoryUsage += command->memoryCost() - _costs.at(_index);
+    _costs[_index] = command->memoryCost();
+    _index++;
+
+    enforceLimit();
+}
+
+void UndoStack::clear()
+{
+    qDeleteAll(_commands);
+    _commands.clear();
+    _costs.clear();
+    _index = 0;
+    _memoryUsage = 0;
+}
+
+int UndoStack::count() const
+{
+    return _commands.size();
+}
+
+int UndoStack::index() const
+{
+    return _index;
+}
+
+int UndoStack::memoryLimit() const
+{
+    return _memoryLimit;
+}
+
+void UndoStack::setMemoryLimit(int bytes)
+{
+    _memoryLimit = bytes;
+    enforceLimit();
+}
+
+int UndoStack::memoryUsage() const
+{
+    return _memoryUsage;
+}
+
+void UndoStack::enforceLimit()
+{
+    // drop the oldest done commands; undone ones are the redo history and
+    // go first when the next command is pushed
+    while ((_memoryUsage > _memoryLimit) && (_index > 1))
+    {
+        _memoryUsage -= _costs.takeFirst();
+        delete _commands.takeFirst();
+        _index--;
+    }
+}
@@ -0,0 +1,47 @@
+#ifndef UNDOSTACK_H
+#define UNDOSTACK_H
+
+/** \cond docNever */
+
+#include <QObject>
+#include <QList>
+
+#include "commands.h"
+
+/*! UndoStack replaces QUndoStack for QHexEdit. It works the same way (push()
+does the command and merges it with the previous one if possible), but it
+keeps the memory held by all commands below memoryLimit(): when a push
+exceeds the limit, the oldest commands are discarded. The newest command is
+always kept, even if it alone is larger than the limit.
+*/
+class UndoStack : public QObject
+{
+public:
+    UndoStack(QObject *parent = 0);
+    ~UndoStack();
+
+    void push(HexCommand *command);
+    void undo();
+    void redo();
+    void clear();
+
+    int count() const;
+    int index() const;                  // commands before index() are done
+
+    int memoryLimit() const;
+    void setMemoryLimit(int bytes);
+    int memoryUsage() const;
+
+private:
+    void enforceLimit();
+
+    QList<HexCommand *> _commands;
+    QList<int> _costs;                  // memoryCost() of each command, as last seen
+    int _index;
+    int _memoryLimit;
+    int _memoryUsage;
+};
+
+/** \endcond docNever */
+
+#endif // UNDOSTACK_H
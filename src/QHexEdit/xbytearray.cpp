@@ -1,12 +1,23 @@
+#include <limits.h>
 #include "xbytearray.h"
 
+const int FILE_PAGE_SIZE = 4096;            // unit of writeback to a mapped file
+const int FILE_CHUNK_SIZE = 1024 * 1024;    // unit of streaming to other files
+const int SEARCH_CHUNK_SIZE = 1024 * 1024;  // searched at once, the data is not built
+const int DUMP_CHUNK_SIZE = 64 * 1024;      // formatted at once, a multiple of 16
+
 XByteArray::XByteArray()
 {
     _oldSize = -99;
     _addressNumbers = 4;
     _addressOffset = 0;
-    _data = QByteArray();
+    _file = 0;
+    _map = 0;
+}
 
+XByteArray::~XByteArray()
+{
+    closeFile();
 }
 
 int XByteArray::addressOffset()
@@ -32,41 +43,176 @@ void XByteArray::setAddressWidth(int width)
     }
 }
 
-QByteArray & XByteArray::data()
+const QByteArray & XByteArray::data()
 {
-    return _data;
+    return _data.data();
 }
 
 void XByteArray::setData(QByteArray data)
 {
-    _data = data;
-    _changedData = QByteArray(data.length(), char(0));
+    _data.setData(data);
+    _changedData.reset(data.length());
+    closeFile();
+    _searchMatches = findMatches(0, size());
+}
+
+bool XByteArray::openFile(const QString & fileName)
+{
+    QFile *file = new QFile(fileName);
+    if (!file->open(QIODevice::ReadOnly) || (file->size() > INT_MAX))
+    {
+        delete file;
+        return false;
+    }
+
+    // an empty file can not be mapped, but needs no mapping either
+    uchar *map = 0;
+    if (file->size() > 0)
+    {
+        map = file->map(0, file->size());
+        if (!map)
+        {
+            delete file;
+            return false;
+        }
+    }
+
+    _data.setMappedData(QByteArray::fromRawData((const char *) map, (int) file->size()));
+    _changedData.reset((int) file->size());
+    closeFile();
+    _file = file;
+    _map = map;
+    _searchMatches = findMatches(0, size());
+    return true;
+}
+
+bool XByteArray::saveFile(const QString & fileName)
+{
+    if (_file && (QFileInfo(fileName) == QFileInfo(*_file)) && (_data.size() == _file->size()))
+    {
+        // rewrite only the pages touched by edits. All of them are read
+        // before the first write, since moved pieces may still refer to the
+        // mapped bytes of other pages.
+        QList<int> pages;
+        QPair<int, int> range;
+        foreach (range, _data.modifiedRanges())
+        {
+            for (int page = range.first / FILE_PAGE_SIZE; page <= (range.first + range.second - 1) / FILE_PAGE_SIZE; page++)
+                if (pages.isEmpty() || (pages.last() != page))
+                    pages.append(page);
+        }
+
+        QList<QByteArray> content;
+        foreach (int page, pages)
+            content.append(_data.mid(page * FILE_PAGE_SIZE, FILE_PAGE_SIZE));
+
+        QFile out(fileName);
+        if (!out.open(QIODevice::ReadWrite))
+            return false;
+        for (int i = 0; i < pages.size(); i++)
+        {
+            if (!out.seek((qint64) pages.at(i) * FILE_PAGE_SIZE) || (out.write(content.at(i)) != content.at(i).size()))
+                return false;
+        }
+        out.close();
+
+        // the file holds the edited data now, so the pieces can refer to
+        // the mapping again
+        _data.setMappedData(QByteArray::fromRawData((const char *) _map, _data.size()));
+        return true;
+    }
+
+    if (_file && (QFileInfo(fileName) == QFileInfo(*_file)))
+    {
+        // the mapping does not survive truncating the file
+        QByteArray content(_data.data().constData(), _data.size());
+        _data.setData(content);
+        closeFile();
+    }
+
+    QFile out(fileName);
+    if (!out.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return false;
+    for (int pos = 0; pos < _data.size(); pos += FILE_CHUNK_SIZE)
+    {
+        QByteArray chunk = _data.mid(pos, FILE_CHUNK_SIZE);
+        if (out.write(chunk) != chunk.size())
+            return false;
+    }
+    out.close();
+    return true;
+}
+
+QString XByteArray::fileName()
+{
+    return _file ? _file->fileName() : QString();
+}
+
+void XByteArray::closeFile()
+{
+    if (_file)
+    {
+        if (_map)
+            _file->unmap(_map);
+        delete _file;
+        _file = 0;
+        _map = 0;
+    }
+}
+
+char XByteArray::at(int i) const
+{
+    return _data.at(i);
+}
+
+QByteArray XByteArray::mid(int pos, int len) const
+{
+    return _data.mid(pos, len);
+}
+
+const char *XByteArray::constData()
+{
+    return _data.constData();
+}
+
+int XByteArray::read(int pos, int len, char *dest) const
+{
+    return _data.read(pos, len, dest);
 }
 
 bool XByteArray::dataChanged(int i)
 {
-    return bool(_changedData[i]);
+    return _changedData.testBit(i);
 }
 
-QByteArray XByteArray::dataChanged(int i, int len)
+ChangeBitmap XByteArray::dataChanged(int i, int len)
 {
     return _changedData.mid(i, len);
 }
 
 void XByteArray::setDataChanged(int i, bool state)
 {
-    _changedData[i] = char(state);
+    _changedData.setBit(i, state);
 }
 
-void XByteArray::setDataChanged(int i, const QByteArray & state)
+void XByteArray::setDataChanged(int i, int len, bool state)
 {
-    int length = state.length();
-    int len;
-    if ((i + length) > _changedData.length())
-        len = _changedData.length() - i;
-    else
-        len = length;
-    _changedData.replace(i, len, state);
+    _changedData.fill(i, len, state);
+}
+
+void XByteArray::setDataChanged(int i, const ChangeBitmap & state)
+{
+    _changedData.replace(i, state);
+}
+
+int XByteArray::nextChanged(int from)
+{
+    return _changedData.nextSet(from);
+}
+
+int XByteArray::nextUnchanged(int from)
+{
+    return _changedData.nextClear(from);
 }
 
 int XByteArray::realAddressNumbers()
@@ -86,83 +232,191 @@ int XByteArray::size()
     return _data.size();
 }
 
-QByteArray & XByteArray::insert(int i, char ch)
+void XByteArray::insert(int i, char ch)
 {
-    _data.insert(i, ch);
-    _changedData.insert(i, char(1));
-    return _data;
+    _data.insert(i, QByteArray(1, ch));
+    _changedData.insert(i, 1, true);
+    updateMatches(i, 0, 1);
 }
 
-QByteArray & XByteArray::insert(int i, const QByteArray & ba)
+void XByteArray::insert(int i, const QByteArray & ba)
 {
     _data.insert(i, ba);
-    _changedData.insert(i, QByteArray(ba.length(), char(1)));
-    return _data;
+    _changedData.insert(i, ba.length(), true);
+    updateMatches(i, 0, ba.length());
 }
 
-QByteArray & XByteArray::remove(int i, int len)
+void XByteArray::remove(int i, int len)
 {
+    len = qMin(len, _data.size() - i);
     _data.remove(i, len);
     _changedData.remove(i, len);
-    return _data;
+    updateMatches(i, len, 0);
 }
 
-QByteArray & XByteArray::replace(int index, char ch)
+void XByteArray::replace(int index, char ch)
 {
-    _data[index] = ch;
-    _changedData[index] = char(1);
-    return _data;
+    _data.replace(index, QByteArray(1, ch));
+    _changedData.setBit(index, true);
+    updateMatches(index, 1, 1);
 }
 
-QByteArray & XByteArray::replace(int index, const QByteArray & ba)
+void XByteArray::replace(int index, const QByteArray & ba)
 {
     int len = ba.length();
-    return replace(index, len, ba);
+    replace(index, len, ba);
 }
 
-QByteArray & XByteArray::replace(int index, int length, const QByteArray & ba)
+void XByteArray::replace(int index, int length, const QByteArray & ba)
 {
     int len;
-    if ((index + length) > _data.length())
-        len = _data.length() - index;
+    if ((index + length) > _data.size())
+        len = _data.size() - index;
     else
         len = length;
-    _data.replace(index, len, ba.mid(0, len));
-    _changedData.replace(index, len, QByteArray(len, char(1)));
-    return _data;
+
+    // a shorter ba shrinks the data, like QByteArray::replace
+    QByteArray after = ba.mid(0, len);
+    if (after.length() < len)
+    {
+        _data.remove(index + after.length(), len - after.length());
+        _changedData.remove(index + after.length(), len - after.length());
+    }
+    _data.replace(index, after);
+    _changedData.fill(index, after.length(), true);
+    updateMatches(index, len, after.length());
+}
+
+void XByteArray::setSearchPattern(const SearchPattern & pattern)
+{
+    _searchPattern = pattern;
+    _searchMatches = findMatches(0, size());
+}
+
+const SearchPattern & XByteArray::searchPattern()
+{
+    return _searchPattern;
+}
+
+const QVector<int> & XByteArray::searchMatches()
+{
+    return _searchMatches;
+}
+
+// matches lying completely inside [from, to)
+QVector<int> XByteArray::findMatches(int from, int to)
+{
+    QVector<int> result;
+    int m = _searchPattern.size();
+    if (m == 0)
+        return result;
+
+    // chunks overlap by m - 1 bytes, each one finds the matches starting
+    // in its first SEARCH_CHUNK_SIZE bytes
+    for (int pos = from; pos + m <= to; pos += SEARCH_CHUNK_SIZE)
+    {
+        QByteArray chunk = _data.mid(pos, qMin(SEARCH_CHUNK_SIZE + m - 1, to - pos));
+        foreach (int match, _searchPattern.findAll(chunk.constData(), chunk.size()))
+            result.append(pos + match);
+    }
+    return result;
+}
+
+int XByteArray::indexOf(const SearchPattern &pattern, int from)
+{
+    int m = pattern.size();
+    if (m == 0)
+        return -1;
+
+    for (int pos = qMax(0, from); pos + m <= size(); pos += SEARCH_CHUNK_SIZE)
+    {
+        QByteArray chunk = _data.mid(pos, qMin(SEARCH_CHUNK_SIZE + m - 1, size() - pos));
+        QVector<int> matches = pattern.findAll(chunk.constData(), chunk.size());
+        if (!matches.isEmpty())
+            return pos + matches.first();
+    }
+    return -1;
+}
+
+int XByteArray::lastIndexOf(const SearchPattern &pattern, int from)
+{
+    int m = pattern.size();
+    if ((m == 0) || (from < 0))
+        return -1;
+
+    // walks backwards, each chunk finds the matches starting in [pos, end)
+    for (int end = qMin(from + 1, size() - m + 1); end > 0; end -= SEARCH_CHUNK_SIZE)
+    {
+        int pos = qMax(0, end - SEARCH_CHUNK_SIZE);
+        QByteArray chunk = _data.mid(pos, end - pos + m - 1);
+        QVector<int> matches = pattern.findAll(chunk.constData(), chunk.size());
+        if (!matches.isEmpty())
+            return pos + matches.last();
+    }
+    return -1;
+}
+
+// oldLen bytes at pos were replaced by newLen bytes
+void XByteArray::updateMatches(int pos, int oldLen, int newLen)
+{
+    int m = _searchPattern.size();
+    if (m == 0)
+        return;
+
+    QVector<int> result;
+    result.reserve(_searchMatches.size());
+
+    // matches ending before the edit stay, the ones overlapping it are
+    // searched again, and the ones after it move along
+    int i = 0;
+    while ((i < _searchMatches.size()) && (_searchMatches.at(i) + m <= pos))
+        result.append(_searchMatches.at(i++));
+    while ((i < _searchMatches.size()) && (_searchMatches.at(i) < pos + oldLen))
+        i++;
+
+    result += findMatches(qMax(0, pos - m + 1), qMin(size(), pos + newLen + m - 1));
+
+    for (; i < _searchMatches.size(); i++)
+        result.append(_searchMatches.at(i) + newLen - oldLen);
+
+    _searchMatches = result;
 }
 
 QChar XByteArray::asciiChar(int index)
 {
-    char ch = _data[index];
+    char ch = _data.at(index);
     if ((ch < 0x20) or (ch > 0x7e))
             ch = '.';
     return QChar(ch);
 }
 
 QString XByteArray::toRedableString(int start, int end)
+{
+    QBuffer buffer;
+    buffer.open(QIODevice::WriteOnly);
+    writeReadableString(&buffer, start, end);
+    return QString::fromLatin1(buffer.data());
+}
+
+bool XByteArray::writeReadableString(QIODevice *device, int start, int end)
 {
     int adrWidth = realAddressNumbers();
     if (_addressNumbers > adrWidth)
         adrWidth = _addressNumbers;
     if (end < 0)
         end = _data.size();
+    if (end <= start)
+        return true;
+
+    // the last line is always filled up to 16 bytes, as far as there is data
+    int stop = qMin(_data.size(), start + ((end - start + 15) / 16) * 16);
 
-    QString result;
-    for (int i=start; i < end; i += 16)
+    HexDumpWriter writer(device, adrWidth);
+    for (int pos = start; pos < stop; pos += DUMP_CHUNK_SIZE)
     {
-        QString adrStr = QString("%1").arg(_addressOffset + i, adrWidth, 16, QChar('0'));
-        QString hexStr;
-        QString ascStr;
-        for (int j=0; j<16; j++)
-        {
-            if ((i + j) < _data.size())
-            {
-                hexStr.append(" ").append(_data.mid(i+j, 1).toHex());
-                ascStr.append(asciiChar(i+j));
-            }
-        }
-        result += adrStr + " " + QString("%1").arg(hexStr, -48) + "  " + QString("%1").arg(ascStr, -17) + "\n";
+        QByteArray chunk = _data.mid(pos, qMin(DUMP_CHUNK_SIZE, stop - pos));
+        if (!writer.write(_addressOffset + pos, chunk.constData(), chunk.size()))
+            return false;
     }
-    return result;
+    return writer.flush();
 }
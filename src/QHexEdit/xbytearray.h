@@ -4,6 +4,10 @@
 /** \cond docNever */
 
 #include <QtCore>
+#include "changebitmap.h"
+#include "hexdumpwriter.h"
+#include "piecetable.h"
+#include "searchpattern.h"
 
 /*! XByteArray represents the content of QHexEcit.
 XByteArray comprehend the data itself and informations to store if it was
@@ -18,6 +22,7 @@ class XByteArray
 {
 public:
     explicit XByteArray();
+    ~XByteArray();
 
     int addressOffset();
     void setAddressOffset(int offset);
@@ -25,41 +30,72 @@ public:
     int addressWidth();
     void setAddressWidth(int width);
 
-    QByteArray & data();
+    const QByteArray & data();              // builds contiguous data, if edits split it
     void setData(QByteArray data);
+    bool openFile(const QString & fileName);    // maps the file, edits are kept in memory
+    bool saveFile(const QString & fileName);
+    QString fileName();                     // the mapped file, empty if there is none
+    char at(int i) const;
+    QByteArray mid(int pos, int len) const;
+    const char *constData();                // contiguous data, valid until the next edit
+    int read(int pos, int len, char *dest) const;
 
     bool dataChanged(int i);
-    QByteArray dataChanged(int i, int len);
+    ChangeBitmap dataChanged(int i, int len);
     void setDataChanged(int i, bool state);
-    void setDataChanged(int i, const QByteArray & state);
+    void setDataChanged(int i, int len, bool state);
+    void setDataChanged(int i, const ChangeBitmap & state);
+    int nextChanged(int from);              // first changed byte at or after from, size() if none
+    int nextUnchanged(int from);            // first unchanged byte at or after from, size() if none
 
     int realAddressNumbers();
     int size();
 
-    QByteArray & insert(int i, char ch);
-    QByteArray & insert(int i, const QByteArray & ba);
+    void insert(int i, char ch);
+    void insert(int i, const QByteArray & ba);
 
-    QByteArray & remove(int pos, int len);
+    void remove(int pos, int len);
 
-    QByteArray & replace(int index, char ch);
-    QByteArray & replace(int index, const QByteArray & ba);
-    QByteArray & replace(int index, int length, const QByteArray & ba);
+    void replace(int index, char ch);
+    void replace(int index, const QByteArray & ba);
+    void replace(int index, int length, const QByteArray & ba);
+
+    // all matches of the search pattern, kept up to date while editing
+    void setSearchPattern(const SearchPattern & pattern);
+    const SearchPattern & searchPattern();
+    const QVector<int> & searchMatches();   // ascending start positions
+
+    // single matches of any pattern, searched in chunks like the matches above
+    int indexOf(const SearchPattern & pattern, int from);       // first match at or after from, -1 if none
+    int lastIndexOf(const SearchPattern & pattern, int from);   // last match at or before from, -1 if none
 
     QChar asciiChar(int index);
     QString toRedableString(int start=0, int end=-1);
+    bool writeReadableString(QIODevice *device, int start=0, int end=-1);   // streamed in chunks
 
 signals:
 
 public slots:
 
 private:
-    QByteArray _data;
-    QByteArray _changedData;
+    Q_DISABLE_COPY(XByteArray)
+    void closeFile();
+    QVector<int> findMatches(int from, int to);
+    void updateMatches(int pos, int oldLen, int newLen);
+
+    PieceTable _data;
+    ChangeBitmap _changedData;              // one bit per byte of _data
 
     int _addressNumbers;                    // wanted width of address area
     int _addressOffset;                     // will be added to the real addres inside bytearray
     int _realAddressNumbers;                // real width of address area (can be greater then wanted width)
     int _oldSize;                           // size of data
+
+    SearchPattern _searchPattern;
+    QVector<int> _searchMatches;
+
+    QFile *_file;                           // mapped file, 0 if the data is in memory
+    uchar *_map;
 };
 
 /** \endcond docNever */
@@ -0,0 +1,397 @@
+#include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QRegExp>
+#include <QStringList>
+#include <QTextStream>
+#include "memorydiff.h"
+#include "batchrunner.h"
+
+BatchJob::BatchJob()
+{
+    resultOffset = 0;
+    hasResultOffset = false;
+}
+
+BatchResult::BatchResult()
+{
+    status = Error;
+    runTime = 0;
+    totalTime = 0;
+    transferredBytes = 0;
+    mismatches = 0;
+    cached = false;
+}
+
+QString BatchResult::statusString() const
+{
+    switch(status)
+    {
+    case Passed:    return "pass";
+    case Failed:    return "fail";
+    case TimedOut:  return "timeout";
+    default:        return "error";
+    }
+}
+
+BatchRunner::BatchRunner(TDT4255Board *board, QObject *parent) :
+    QObject(parent)
+{
+    m_board = board;
+    m_runner = new Ex1Runner(board, this);
+    m_totalTime = 0;
+    m_cache = 0;
+    m_boardReady = false;
+}
+
+bool BatchRunner::loadManifest(const QString &fileName)
+{
+    QFile f(fileName);
+    if(!f.open(QIODevice::ReadOnly | QIODevice::Text))
+        return fail("could not open " + fileName);
+
+    QDir dir = QFileInfo(fileName).absoluteDir();
+    QList<BatchJob> jobs;
+    int lineNumber = 0;
+
+    while(!f.atEnd())
+    {
+        QString line = QString::fromLocal8Bit(f.readLine()).trimmed();
+        lineNumber++;
+        if(line.isEmpty() || line.startsWith('#'))
+            continue;
+
+        QStringList fields = line.split(QRegExp("\\s+"), QString::SkipEmptyParts);
+        if(fields.size() < 4 || fields.size() > 5)
+            return fail(QString("%1:%2: expected name, instructions, data, expected and an optional result offset").arg(fileName).arg(lineNumber));
+
+        BatchJob job;
+        job.name = fields.at(0);
+        job.instFile = dir.absoluteFilePath(fields.at(1));
+        if(fields.at(2) != "-")
+            job.dataFile = dir.absoluteFilePath(fields.at(2));
+        job.expectedFile = dir.absoluteFilePath(fields.at(3));
+
+        if(fields.size() == 5)
+        {
+            job.resultOffset = fields.at(4).toUInt(&job.hasResultOffset, 0);
+            if(!job.hasResultOffset)
+                return fail(QString("%1:%2: invalid result offset %3").arg(fileName).arg(lineNumber).arg(fields.at(4)));
+        }
+
+        jobs.append(job);
+    }
+
+    m_jobs = jobs;
+    return true;
+}
+
+void BatchRunner::setBitfile(const QString &fileName)
+{
+    m_bitfile = fileName;
+}
+
+void BatchRunner::setResultCache(ResultCache *cache)
+{
+    m_cache = cache;
+}
+
+QList<BatchJob> BatchRunner::jobs() const
+{
+    return m_jobs;
+}
+
+QString BatchRunner::errorString() const
+{
+    return m_errorString;
+}
+
+void BatchRunner::run()
+{
+    m_results.clear();
+    m_boardInst.clear();
+    m_instRegion = m_board->memoryMap().region(TDT4255_REGION_EX1_INSMEM);
+    m_dataRegion = m_board->memoryMap().region(TDT4255_REGION_EX1_DATMEM);
+    m_boardReady = false;
+
+    // results are only reusable for a known design
+    m_bitfileHash.clear();
+    if(!m_bitfile.isEmpty())
+        m_bitfileHash = ResultCache::hashFile(m_bitfile);
+
+    QElapsedTimer clock;
+    clock.start();
+
+    for(int i = 0; i < m_jobs.size(); i++)
+    {
+        m_results.append(runJob(m_jobs.at(i)));
+        emit jobFinished(i, m_jobs.size());
+    }
+
+    m_totalTime = clock.elapsed();
+}
+
+QList<BatchResult> BatchRunner::results() const
+{
+    return m_results;
+}
+
+int BatchRunner::passedCount() const
+{
+    int passed = 0;
+    foreach(BatchResult r, m_results)
+    {
+        if(r.status == BatchResult::Passed)
+            passed++;
+    }
+
+    return passed;
+}
+
+qint64 BatchRunner::totalTime() const
+{
+    return m_totalTime;
+}
+
+double BatchRunner::jobsPerMinute() const
+{
+    if(m_totalTime <= 0)
+        return 0;
+
+    return m_results.size() * 60000.0 / m_totalTime;
+}
+
+bool BatchRunner::writeReport(QIODevice *device) const
+{
+    QTextStream out(device);
+    out << "job,status,cached,run_ms,total_ms,bytes_written,mismatches,message\n";
+
+    foreach(BatchResult r, m_results)
+    {
+        // quotes in messages are doubled, as CSV requires
+        QString message = r.message;
+        message.replace('"', "\"\"");
+        out << r.name << ',' << r.statusString() << ',' << (r.cached ? "yes" : "no") << ',' << r.runTime << ',' << r.totalTime << ','
+            << r.transferredBytes << ',' << r.mismatches << ",\"" << message << "\"\n";
+    }
+
+    out.flush();
+    return out.status() == QTextStream::Ok;
+}
+
+BatchResult BatchRunner::runJob(const BatchJob &job)
+{
+    BatchResult r;
+    r.name = job.name;
+
+    QElapsedTimer clock;
+    clock.start();
+
+    // an instruction image may also carry data, like an ELF program, which
+    // is used unless the job names a data file
+    MemoryImage inst, data;
+    QByteArray expected;
+    if(!loadImage(job.instFile, m_instRegion, inst)
+            || (!job.dataFile.isEmpty() && !loadImage(job.dataFile, m_dataRegion, data))
+            || !loadExpected(job.expectedFile, expected))
+    {
+        r.message = m_errorString;
+        return r;
+    }
+    if(job.dataFile.isEmpty())
+        data = inst;
+
+    CompletionCriteria criteria = m_board->memoryMap().completionCriteria();
+    if(m_programs.contains(job.instFile))
+    {
+        const ElfImage & program = m_programs[job.instFile];
+        if(program.hasSymbol(TDT4255_SYMBOL_RESULT))
+            criteria.resultAddress = program.symbol(TDT4255_SYMBOL_RESULT).address;
+        if(program.hasSymbol(TDT4255_SYMBOL_DONE))
+        {
+            criteria.sentinelAddress = program.symbol(TDT4255_SYMBOL_DONE).address;
+            criteria.hasSentinel = true;
+        }
+    }
+    if(job.hasResultOffset)
+        criteria.resultAddress = m_dataRegion.baseAddress + job.resultOffset;
+    criteria.resultSize = expected.size();
+
+    if(!m_dataRegion.contains(criteria.resultAddress, criteria.resultSize))
+    {
+        r.message = "expected result does not fit the data memory";
+        return r;
+    }
+
+    // holes read as zero in both memories
+    QByteArray instMem(m_instRegion.size, 0), dataMem(m_dataRegion.size, 0);
+    foreach(ImageSegment s, inst.segmentsIn(m_instRegion))
+        instMem.replace(s.address - m_instRegion.baseAddress, s.data.size(), s.data);
+    foreach(ImageSegment s, data.segmentsIn(m_dataRegion))
+        dataMem.replace(s.address - m_dataRegion.baseAddress, s.data.size(), s.data);
+
+    QByteArray result;
+    QByteArray key;
+    if(m_cache && !m_bitfileHash.isEmpty())
+    {
+        key = ResultCache::key(m_bitfileHash, instMem, dataMem, criteria);
+        if(m_cache->lookup(key, result, r.runTime))
+        {
+            r.cached = true;
+            compareResult(r, result, expected);
+            r.totalTime = clock.elapsed();
+            return r;
+        }
+    }
+
+    if(!prepareBoard())
+    {
+        r.message = m_errorString;
+        r.totalTime = clock.elapsed();
+        return r;
+    }
+
+    QList<BoardOperation> ops;
+    foreach(DiffRange d, MemoryDiff::compare(m_boardInst, instMem))
+    {
+        if(d.offset < instMem.size())
+            ops << BoardOperation::write(m_instRegion.baseAddress + d.offset, instMem.mid(d.offset, d.length));
+    }
+    ops << BoardOperation::write(m_dataRegion.baseAddress, dataMem)
+        << BoardOperation::write(TDT4255_EX1_REGADR_RESTPROC, QByteArray(1, 1))
+        << BoardOperation::write(TDT4255_EX1_REGADR_RESTPROC, QByteArray(1, 0));
+
+    foreach(BoardOperation op, ops)
+        r.transferredBytes += op.data.size();
+
+    // the instruction memory is unknown after a failed transaction
+    m_boardInst.clear();
+    if(!m_board->executeTransaction(ops, false))
+    {
+        r.message = "writing the memories failed";
+        r.totalTime = clock.elapsed();
+        return r;
+    }
+    m_boardInst = instMem;
+
+    switch(m_runner->runToCompletion(criteria, result))
+    {
+    case Ex1Runner::Completed:
+        compareResult(r, result, expected);
+        if(!key.isEmpty())
+            m_cache->store(key, result, m_runner->lastRunTime());
+        break;
+    case Ex1Runner::TimedOut:
+        r.status = BatchResult::TimedOut;
+        r.message = QString("no completion within %1 ms").arg(criteria.timeout);
+        break;
+    case Ex1Runner::BoardError:
+        r.message = "communication with the board failed during the run";
+        break;
+    case Ex1Runner::NoSentinel:
+        r.message = "no sentinel configured";
+        break;
+    }
+
+    r.runTime = m_runner->lastRunTime();
+    r.totalTime = clock.elapsed();
+    return r;
+}
+
+void BatchRunner::compareResult(BatchResult &r, const QByteArray &result, const QByteArray &expected)
+{
+    r.mismatches = MemoryDiff::differingBytes(MemoryDiff::compare(result, expected));
+    r.status = (r.mismatches == 0) ? BatchResult::Passed : BatchResult::Failed;
+    if(r.mismatches > 0)
+        r.message = QString("%1 of %2 result bytes differ").arg(r.mismatches).arg(expected.size());
+}
+
+bool BatchRunner::prepareBoard()
+{
+    if(m_boardReady)
+        return true;
+
+    // opened first, so that flashing and verifying do not connect on their
+    // own, which reports failures in a dialog
+    QString error;
+    if(!m_board->openBoard(error))
+        return fail(error);
+
+    if(!m_bitfile.isEmpty() && !m_board->flashBitfile(m_bitfile))
+        return fail("could not flash " + m_bitfile);
+
+    if(!m_board->verifyConnection(TDT4255_EX1_REGADR_MAGIC_ID, TDT4255_EX1_REGVAL_MAGIC_ID))
+        return fail("Ex1 framework not found on the board");
+
+    if(!m_board->writeRegister(TDT4255_EX1_REGADR_ENABPROC, 0))
+        return fail("could not stop the processor");
+
+    m_boardReady = true;
+    return true;
+}
+
+bool BatchRunner::loadImage(const QString &fileName, const MemoryRegion &region, MemoryImage &image)
+{
+    QString key = region.name + ":" + fileName;
+
+    if(m_programs.contains(fileName))
+    {
+        image = m_programs[fileName].image();
+        return true;
+    }
+    if(m_images.contains(key))
+    {
+        image = m_images[key];
+        return true;
+    }
+
+    if(ElfImage::isElf(fileName))
+    {
+        ElfImage program;
+        if(!program.load(fileName, m_instRegion.baseAddress, m_dataRegion.baseAddress, m_dataRegion.size))
+            return fail(fileName + ": " + program.errorString());
+
+        m_programs.insert(fileName, program);
+        image = program.image();
+        return true;
+    }
+
+    // as in the memory views, images covering neither memory are placed
+    // at the start of the one they are loaded for
+    MemoryImage loaded;
+    if(!loaded.load(fileName, region.baseAddress))
+        return fail(fileName + ": " + loaded.errorString());
+    if(loaded.segmentsIn(m_instRegion).isEmpty() && loaded.segmentsIn(m_dataRegion).isEmpty())
+        loaded.relocate(region.baseAddress);
+
+    m_images.insert(key, loaded);
+    image = loaded;
+    return true;
+}
+
+bool BatchRunner::loadExpected(const QString &fileName, QByteArray &expected)
+{
+    if(!m_expected.contains(fileName))
+    {
+        QFile f(fileName);
+        if(!f.open(QIODevice::ReadOnly))
+            return fail("could not open " + fileName);
+
+        m_expected.insert(fileName, f.readAll());
+    }
+
+    expected = m_expected.value(fileName);
+    if(expected.isEmpty())
+        return fail(fileName + " is empty");
+
+    return true;
+}
+
+bool BatchRunner::fail(QString message)
+{
+    qDebug() << "batch:" << message;
+    m_errorString = message;
+    return false;
+}
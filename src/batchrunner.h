@@ -0,0 +1,127 @@
+#ifndef BATCHRUNNER_H
+#define BATCHRUNNER_H
+
+#include <QObject>
+#include <QIODevice>
+#include <QList>
+#include <QMap>
+#include "tdt4255board.h"
+#include "ex1runner.h"
+#include "memoryimage.h"
+#include "elfimage.h"
+#include "resultcache.h"
+
+// one program run of a batch: the images to load and the bytes expected in
+// the data memory once the program has completed
+struct BatchJob
+{
+    BatchJob();
+
+    QString name;
+    QString instFile;
+    QString dataFile;           // empty: zeroed, or the data of an ELF program
+    QString expectedFile;
+    quint32 resultOffset;       // relative to ex1.dmem
+    bool hasResultOffset;       // otherwise taken from the completion criteria
+};
+
+struct BatchResult
+{
+    enum Status { Passed, Failed, TimedOut, Error };
+
+    BatchResult();
+
+    QString statusString() const;
+
+    QString name;
+    Status status;
+    QString message;
+    qint64 runTime;             // from start until completion, in milliseconds
+    qint64 totalTime;           // including the transfers, in milliseconds
+    int transferredBytes;
+    int mismatches;             // bytes differing from the expected result
+    bool cached;                // answered from the result cache
+};
+
+/*
+ BatchRunner executes a manifest of Ex1 jobs back-to-back and collects a
+ pass/fail result with timings for each. The manifest has one job per line,
+ blank lines and lines starting with # are ignored:
+
+ # name     instructions    data            expected        [resultOffset]
+ sub01      sub01/prog.elf  -               vec/a.expected
+ sub02      sub02/prog.hex  vec/a.hex       vec/a.expected  0x40
+
+ Paths are relative to the manifest, - stands for no data file. Images are
+ loaded as in the memory views (raw, Intel HEX, S-record or ELF). The
+ expected file holds the raw bytes of the result range, which starts at
+ resultOffset in ex1.dmem, at the "result" symbol of an ELF program, or
+ where the completion criteria put it.
+
+ Transfers are kept to a minimum: images and expected results are read
+ once per batch, and since programs cannot modify the instruction memory,
+ only the bytes differing from the program already on the board are
+ written to it. The data memory is rewritten as a whole, holes as zeros,
+ so no job sees what an earlier one left behind. The writes and the
+ processor reset of a job go out as a single transaction, and only the
+ result range is read back.
+
+ With a result cache and a bitfile, jobs run before on the same inputs are
+ answered from the cache. The board is only flashed and connected once the
+ first job misses it, so a fully cached batch does not touch the board.
+*/
+class BatchRunner : public QObject
+{
+    Q_OBJECT
+public:
+    explicit BatchRunner(TDT4255Board * board, QObject *parent = 0);
+
+    bool loadManifest(const QString & fileName);
+    // the bitfile is flashed before the first run; without one, the board
+    // must already be configured and no results are cached
+    void setBitfile(const QString & fileName);
+    void setResultCache(ResultCache * cache);
+    QList<BatchJob> jobs() const;
+    QString errorString() const;
+
+    // runs all jobs, the results are available afterwards
+    void run();
+    QList<BatchResult> results() const;
+    int passedCount() const;
+    qint64 totalTime() const;
+    double jobsPerMinute() const;
+
+    // writes the results as CSV, one row per job
+    bool writeReport(QIODevice * device) const;
+
+signals:
+    void jobFinished(int index, int count);
+
+private:
+    BatchResult runJob(const BatchJob & job);
+    void compareResult(BatchResult & r, const QByteArray & result, const QByteArray & expected);
+    bool prepareBoard();
+    bool loadImage(const QString & fileName, const MemoryRegion & region, MemoryImage & image);
+    bool loadExpected(const QString & fileName, QByteArray & expected);
+    bool fail(QString message);
+
+    TDT4255Board * m_board;
+    Ex1Runner * m_runner;
+    QList<BatchJob> m_jobs;
+    QList<BatchResult> m_results;
+    QString m_errorString;
+    qint64 m_totalTime;
+    MemoryRegion m_instRegion;
+    MemoryRegion m_dataRegion;
+    QString m_bitfile;
+    QByteArray m_bitfileHash;
+    ResultCache * m_cache;
+    bool m_boardReady;
+
+    QMap<QString, MemoryImage> m_images;        // parsed images, by region and file
+    QMap<QString, ElfImage> m_programs;         // parsed ELF programs, by file
+    QMap<QString, QByteArray> m_expected;       // expected results, by file
+    QByteArray m_boardInst;                     // instruction memory contents, if known
+};
+
+#endif // BATCHRUNNER_H
@@ -0,0 +1,181 @@
+#include <QDebug>
+#include <QSocketNotifier>
+#include "boardhotplugmonitor.h"
+
+#ifdef TDT4255_HAVE_UDEV
+#include <libudev.h>
+
+static bool isTDT4255Device(struct udev_device * dev)
+{
+    // udev attaches the USB IDs as properties to the tty device itself,
+    // prefer those since they are also present on remove events
+    const char * vid = udev_device_get_property_value(dev, "ID_VENDOR_ID");
+    const char * pid = udev_device_get_property_value(dev, "ID_MODEL_ID");
+
+    if(!vid || !pid)
+    {
+        struct udev_device * usbDev = udev_device_get_parent_with_subsystem_devtype(dev, "usb", "usb_device");
+        if(!usbDev)
+            return false;
+        vid = udev_device_get_sysattr_value(usbDev, "idVendor");
+        pid = udev_device_get_sysattr_value(usbDev, "idProduct");
+    }
+
+    if(!vid || !pid)
+        return false;
+
+    return QString::fromLatin1(vid).toLower() == TDT4255_USB_VENDOR_ID &&
+           QString::fromLatin1(pid).toLower() == TDT4255_USB_PRODUCT_ID;
+}
+#endif
+
+BoardHotplugMonitor::BoardHotplugMonitor(QObject *parent) :
+    QObject(parent)
+{
+    m_udev = 0;
+    m_monitor = 0;
+    m_notifier = 0;
+}
+
+BoardHotplugMonitor::~BoardHotplugMonitor()
+{
+    stop();
+}
+
+bool BoardHotplugMonitor::start()
+{
+#ifdef TDT4255_HAVE_UDEV
+    if(isActive())
+        return true;
+
+    m_udev = udev_new();
+    if(!m_udev)
+    {
+        qDebug() << "BoardHotplugMonitor: could not create udev context";
+        return false;
+    }
+
+    m_monitor = udev_monitor_new_from_netlink(m_udev, "udev");
+    if(!m_monitor)
+    {
+        qDebug() << "BoardHotplugMonitor: could not create udev monitor";
+        stop();
+        return false;
+    }
+
+    udev_monitor_filter_add_match_subsystem_devtype(m_monitor, "tty", NULL);
+
+    if(udev_monitor_enable_receiving(m_monitor) < 0)
+    {
+        qDebug() << "BoardHotplugMonitor: could not enable udev monitor";
+        stop();
+        return false;
+    }
+
+    m_notifier = new QSocketNotifier(udev_monitor_get_fd(m_monitor), QSocketNotifier::Read, this);
+    connect(m_notifier, SIGNAL(activated(int)), this, SLOT(udevEventReady()));
+
+    // seed the list of attached boards so removals are recognized
+    findAttachedBoard();
+
+    return true;
+#else
+    return false;
+#endif
+}
+
+void BoardHotplugMonitor::stop()
+{
+    delete m_notifier;
+    m_notifier = 0;
+
+#ifdef TDT4255_HAVE_UDEV
+    if(m_monitor)
+        udev_monitor_unref(m_monitor);
+    if(m_udev)
+        udev_unref(m_udev);
+#endif
+
+    m_monitor = 0;
+    m_udev = 0;
+    m_attachedNodes.clear();
+}
+
+bool BoardHotplugMonitor::isActive()
+{
+    return m_notifier != 0;
+}
+
+QString BoardHotplugMonitor::findAttachedBoard()
+{
+    QString result;
+
+#ifdef TDT4255_HAVE_UDEV
+    bool ownContext = (m_udev == 0);
+    struct udev * ctx = ownContext ? udev_new() : m_udev;
+    if(!ctx)
+        return result;
+
+    struct udev_enumerate * enumerate = udev_enumerate_new(ctx);
+    udev_enumerate_add_match_subsystem(enumerate, "tty");
+    udev_enumerate_scan_devices(enumerate);
+
+    struct udev_list_entry * entry;
+    udev_list_entry_foreach(entry, udev_enumerate_get_list_entry(enumerate))
+    {
+        struct udev_device * dev = udev_device_new_from_syspath(ctx, udev_list_entry_get_name(entry));
+        if(!dev)
+            continue;
+
+        const char * devNode = udev_device_get_devnode(dev);
+        if(devNode && isTDT4255Device(dev))
+        {
+            QString node = QString::fromLocal8Bit(devNode);
+            m_attachedNodes.insert(node);
+            if(result.isEmpty() || node < result)
+                result = node;
+        }
+
+        udev_device_unref(dev);
+    }
+
+    udev_enumerate_unref(enumerate);
+    if(ownContext)
+        udev_unref(ctx);
+#endif
+
+    return result;
+}
+
+void BoardHotplugMonitor::udevEventReady()
+{
+#ifdef TDT4255_HAVE_UDEV
+    struct udev_device * dev = udev_monitor_receive_device(m_monitor);
+    if(!dev)
+        return;
+
+    const char * action = udev_device_get_action(dev);
+    const char * devNode = udev_device_get_devnode(dev);
+
+    if(action && devNode)
+    {
+        QString node = QString::fromLocal8Bit(devNode);
+        QString act = QString::fromLatin1(action);
+
+        if(act == "add" && isTDT4255Device(dev))
+        {
+            qDebug() << "BoardHotplugMonitor: board attached at" << node;
+            m_attachedNodes.insert(node);
+            emit boardAttached(node);
+        }
+        else if(act == "remove" && (m_attachedNodes.contains(node) || isTDT4255Device(dev)))
+        {
+            qDebug() << "BoardHotplugMonitor: board detached from" << node;
+            m_attachedNodes.remove(node);
+            emit boardDetached(node);
+        }
+    }
+
+    udev_device_unref(dev);
+#endif
+}
@@ -0,0 +1,53 @@
+#ifndef BOARDHOTPLUGMONITOR_H
+#define BOARDHOTPLUGMONITOR_H
+
+#include <QObject>
+#include <QSet>
+#include <QString>
+
+class QSocketNotifier;
+struct udev;
+struct udev_monitor;
+
+// USB IDs of the Avnet Spartan-6 LX16 Evaluation Kit serial port,
+// see udev-rules/s6lxek.rules
+#define TDT4255_USB_VENDOR_ID           "04b4"
+#define TDT4255_USB_PRODUCT_ID          "cdca"
+
+// Watches udev netlink events for tty devices that belong to the
+// evaluation kit and reports them as they come and go. Without udev
+// support (non-Linux builds) start() returns false and the caller is
+// expected to fall back to scanning for ports manually.
+class BoardHotplugMonitor : public QObject
+{
+    Q_OBJECT
+public:
+    explicit BoardHotplugMonitor(QObject *parent = 0);
+    ~BoardHotplugMonitor();
+
+    bool start();
+    void stop();
+    bool isActive();
+
+    // returns the device node (e.g /dev/ttyACM0) of the first matching
+    // board that is currently attached, or an empty string if none
+    QString findAttachedBoard();
+
+signals:
+    void boardAttached(QString devNode);
+    void boardDetached(QString devNode);
+
+private slots:
+    void udevEventReady();
+
+private:
+    struct udev * m_udev;
+    struct udev_monitor * m_monitor;
+    QSocketNotifier * m_notifier;
+
+    // device nodes reported as attached, so that removals can still be
+    // matched when udev no longer provides the USB attributes
+    QSet<QString> m_attachedNodes;
+};
+
+#endif // BOARDHOTPLUGMONITOR_H
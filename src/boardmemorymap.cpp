@@ -0,0 +1,287 @@
+#include <QDebug>
+#include <QFileInfo>
+#include <QSettings>
+#include <QStringList>
+#include <QCoreApplication>
+#include "tdt4255board.h"
+#include "boardmemorymap.h"
+
+MemoryRegion::MemoryRegion()
+{
+    baseAddress = 0;
+    size = 0;
+    wordWidth = 1;
+    access = NoAccess;
+}
+
+MemoryRegion::MemoryRegion(QString name, quint32 baseAddress, quint32 size, int wordWidth, int access)
+{
+    this->name = name;
+    this->baseAddress = baseAddress;
+    this->size = size;
+    this->wordWidth = wordWidth;
+    this->access = access;
+}
+
+bool MemoryRegion::isValid() const
+{
+    return size > 0 && wordWidth > 0;
+}
+
+bool MemoryRegion::isReadable() const
+{
+    return (access & Read) != 0;
+}
+
+bool MemoryRegion::isWritable() const
+{
+    return (access & Write) != 0;
+}
+
+bool MemoryRegion::contains(quint32 address, quint32 length) const
+{
+    if(address < baseAddress)
+        return false;
+
+    quint32 offset = address - baseAddress;
+    return offset < size && length <= size - offset;
+}
+
+CompletionCriteria::CompletionCriteria()
+{
+    hasSentinel = false;
+    sentinelAddress = 0;
+    sentinelWidth = 4;
+    sentinelValue = 1;
+    sentinelMask = 0xFFFFFFFF;
+    resultAddress = 0;
+    resultSize = 0;
+    timeout = 5000;
+}
+
+BoardMemoryMap::BoardMemoryMap()
+{
+    setDefaults();
+}
+
+void BoardMemoryMap::setDefaults()
+{
+    m_regions.clear();
+    m_completion.clear();
+    m_addressBits = TDT4255_ADDRBITS_NARROW;
+    m_hasChecksumUnit = false;
+    m_checksumAddress = 0;
+
+    // 256 instructions of 16 bits each
+    setRegion(MemoryRegion(TDT4255_REGION_EX0_PROGRAM, TDT4255_EX0_PRGDAT_BASEADDR, 512, 2, MemoryRegion::ReadWrite));
+    setRegion(MemoryRegion(TDT4255_REGION_EX1_INSMEM, TDT4255_EX1_INSMEM_BASEADDR, 256, 4, MemoryRegion::ReadWrite));
+    setRegion(MemoryRegion(TDT4255_REGION_EX1_DATMEM, TDT4255_EX1_DATMEM_BASEADDR, 256, 4, MemoryRegion::ReadWrite));
+}
+
+bool BoardMemoryMap::load(QString fileName)
+{
+    if(!QFileInfo(fileName).exists())
+        return false;
+
+    QSettings desc(fileName, QSettings::IniFormat);
+
+    if(desc.status() != QSettings::NoError)
+    {
+        qDebug() << "could not parse memory map descriptor" << fileName;
+        return false;
+    }
+
+    int addressBits = desc.value("board/addressBits", m_addressBits).toInt();
+    if(addressBits != TDT4255_ADDRBITS_NARROW && addressBits != TDT4255_ADDRBITS_WIDE)
+    {
+        qDebug() << "unsupported address width" << addressBits << "in" << fileName;
+        return false;
+    }
+    quint64 maxAddress = (Q_UINT64_C(1) << addressBits) - 1;
+
+    quint32 checksumAddress = 0;
+    bool hasChecksumUnit = desc.contains("board/checksum");
+    if(hasChecksumUnit && !parseNumber(desc.value("board/checksum").toString(), checksumAddress))
+    {
+        qDebug() << "invalid checksum unit address in" << fileName;
+        return false;
+    }
+
+    QMap<QString, quint32> completion;
+    desc.beginGroup("completion");
+    foreach(QString key, desc.childKeys())
+    {
+        quint32 val = 0;
+        if(!parseNumber(desc.value(key).toString(), val))
+        {
+            qDebug() << "invalid completion setting" << key << "in" << fileName;
+            return false;
+        }
+        completion[key] = val;
+    }
+    desc.endGroup();
+
+    // validate all regions before touching the current map, so that a
+    // broken descriptor leaves the defaults intact
+    QList<MemoryRegion> loaded;
+
+    foreach(QString group, desc.childGroups())
+    {
+        if(group == "board" || group == "completion")
+            continue;
+
+        desc.beginGroup(group);
+
+        MemoryRegion r;
+        r.name = group;
+        bool ok = parseNumber(desc.value("base").toString(), r.baseAddress);
+        ok &= parseNumber(desc.value("size").toString(), r.size);
+
+        quint32 wordWidth = 1;
+        if(desc.contains("wordWidth"))
+            ok &= parseNumber(desc.value("wordWidth").toString(), wordWidth);
+        r.wordWidth = wordWidth;
+
+        r.access = parseAccess(desc.value("access", "rw").toString());
+
+        desc.endGroup();
+
+        if(!ok || !r.isValid() || r.access < 0 || (r.size % r.wordWidth) != 0
+                || (quint64) r.baseAddress + r.size - 1 > maxAddress)
+        {
+            qDebug() << "invalid memory region" << group << "in" << fileName;
+            return false;
+        }
+
+        loaded.append(r);
+    }
+
+    m_addressBits = addressBits;
+    m_hasChecksumUnit = hasChecksumUnit;
+    m_checksumAddress = checksumAddress;
+    m_completion = completion;
+
+    foreach(MemoryRegion r, loaded)
+        setRegion(r);
+
+    qDebug() << "loaded" << loaded.size() << "memory regions from" << fileName;
+
+    return true;
+}
+
+QString BoardMemoryMap::defaultFileName()
+{
+    return QCoreApplication::applicationDirPath() + "/memorymap.ini";
+}
+
+bool BoardMemoryMap::hasRegion(QString name) const
+{
+    return m_regions.contains(name);
+}
+
+MemoryRegion BoardMemoryMap::region(QString name) const
+{
+    return m_regions.value(name);
+}
+
+QList<MemoryRegion> BoardMemoryMap::regions() const
+{
+    return m_regions.values();
+}
+
+void BoardMemoryMap::setRegion(const MemoryRegion &region)
+{
+    m_regions[region.name] = region;
+}
+
+MemoryRegion BoardMemoryMap::regionForAddress(quint32 address) const
+{
+    foreach(MemoryRegion r, m_regions)
+    {
+        if(r.contains(address))
+            return r;
+    }
+
+    return MemoryRegion();
+}
+
+int BoardMemoryMap::addressBits() const
+{
+    return m_addressBits;
+}
+
+void BoardMemoryMap::setAddressBits(int bits)
+{
+    if(bits == TDT4255_ADDRBITS_NARROW || bits == TDT4255_ADDRBITS_WIDE)
+        m_addressBits = bits;
+}
+
+quint32 BoardMemoryMap::maxAddress() const
+{
+    return (quint32) ((Q_UINT64_C(1) << m_addressBits) - 1);
+}
+
+bool BoardMemoryMap::hasChecksumUnit() const
+{
+    return m_hasChecksumUnit;
+}
+
+quint32 BoardMemoryMap::checksumAddress() const
+{
+    return m_checksumAddress;
+}
+
+CompletionCriteria BoardMemoryMap::completionCriteria() const
+{
+    MemoryRegion dmem = region(TDT4255_REGION_EX1_DATMEM);
+    CompletionCriteria c;
+
+    c.sentinelWidth = qMin(dmem.wordWidth, 4);
+    c.hasSentinel = m_completion.contains("sentinel");
+    c.sentinelAddress = m_completion.value("sentinel", 0);
+    c.sentinelValue = m_completion.value("value", c.sentinelValue);
+    c.sentinelMask = m_completion.value("mask", c.sentinelMask);
+    c.resultAddress = dmem.baseAddress + m_completion.value("resultOffset", 0);
+    c.resultSize = m_completion.value("resultSize", dmem.size);
+    c.timeout = m_completion.value("timeout", c.timeout);
+
+    return c;
+}
+
+bool BoardMemoryMap::parseNumber(QString str, quint32 &value)
+{
+    str = str.trimmed().toUpper();
+
+    quint32 multiplier = 1;
+    if(str.endsWith("K") && !str.startsWith("0X"))
+        multiplier = 1024;
+    else if(str.endsWith("M") && !str.startsWith("0X"))
+        multiplier = 1024 * 1024;
+
+    if(multiplier != 1)
+        str.chop(1);
+
+    // base 0 accepts both decimal and 0x-prefixed hexadecimal values
+    bool ok = false;
+    quint32 val = str.toUInt(&ok, 0);
+
+    if(!ok || (quint64) val * multiplier > 0xFFFFFFFFULL)
+        return false;
+
+    value = val * multiplier;
+    return true;
+}
+
+int BoardMemoryMap::parseAccess(QString str)
+{
+    str = str.trimmed().toLower();
+
+    if(str == "rw")
+        return MemoryRegion::ReadWrite;
+    if(str == "r")
+        return MemoryRegion::Read;
+    if(str == "w")
+        return MemoryRegion::Write;
+
+    return -1;
+}
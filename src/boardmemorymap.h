@@ -0,0 +1,139 @@
+#ifndef BOARDMEMORYMAP_H
+#define BOARDMEMORYMAP_H
+
+#include <QString>
+#include <QList>
+#include <QMap>
+
+// names of the regions used by the exercise tabs
+#define TDT4255_REGION_EX0_PROGRAM      "ex0.program"
+#define TDT4255_REGION_EX1_INSMEM       "ex1.imem"
+#define TDT4255_REGION_EX1_DATMEM       "ex1.dmem"
+
+// widths of the address field in the board protocol
+#define TDT4255_ADDRBITS_NARROW         16
+#define TDT4255_ADDRBITS_WIDE           32
+
+// describes one memory region exposed by the exercise framework
+struct MemoryRegion
+{
+    enum Access { NoAccess = 0, Read = 1, Write = 2, ReadWrite = 3 };
+
+    MemoryRegion();
+    MemoryRegion(QString name, quint32 baseAddress, quint32 size, int wordWidth = 1, int access = ReadWrite);
+
+    bool isValid() const;
+    bool isReadable() const;
+    bool isWritable() const;
+    bool contains(quint32 address, quint32 length = 1) const;
+
+    QString name;
+    quint32 baseAddress;
+    quint32 size;           // in bytes
+    int wordWidth;          // in bytes
+    int access;             // combination of Access flags
+};
+
+// describes how the end of an Ex1 program run is detected: the run is
+// complete once (sentinel word & mask) == value, after which the result
+// range is read back
+struct CompletionCriteria
+{
+    CompletionCriteria();
+
+    bool hasSentinel;           // runs are refused without one
+    quint32 sentinelAddress;
+    int sentinelWidth;          // in bytes, stored little-endian
+    quint32 sentinelValue;
+    quint32 sentinelMask;
+    quint32 resultAddress;
+    quint32 resultSize;
+    int timeout;                // in milliseconds
+};
+
+/*
+ BoardMemoryMap holds the memory regions of the exercise frameworks. The
+ compiled-in defaults describe the 256-byte memories of the standard lab
+ designs, and can be overridden at runtime by an INI-style descriptor with
+ one group per region, for instance:
+
+ [ex1.imem]
+ base=0xC000
+ size=4096
+ wordWidth=4
+ access=rw
+
+ access is one of r, w, rw. Sizes accept the K/M suffixes (e.g 16K).
+
+ The optional [board] group selects the address width used on the wire:
+
+ [board]
+ addressBits=32
+
+ Boards default to the 16-bit form, which is the only one older exercise
+ frameworks understand.
+
+ Frameworks with a checksum unit declare its base in the [board] group
+ (checksum=0x4010). The unit computes the CRC-32 (IEEE 802.3) of a range
+ of memory: the range is written as base (+0, 4 bytes) and length (+4,
+ 2 bytes), both little-endian, and the CRC is read back from +8 (4 bytes,
+ little-endian). TDT4255Board::verifyBuffer() uses it when present.
+
+ The optional [completion] group configures run-to-completion for Ex1
+ (all keys optional, see CompletionCriteria):
+
+ [completion]
+ sentinel=0x80FC
+ value=1
+ mask=0xFFFFFFFF
+ resultOffset=0
+ resultSize=256
+ timeout=5000
+
+ There is no default sentinel: any word of ex1.dmem may hold user data,
+ so run-to-completion is refused until one is configured here (or given
+ by the "done" symbol of a loaded ELF program). A value of 1 marks
+ completion and the whole data memory is read back by default. Offsets
+ are relative to the base of ex1.dmem.
+*/
+class BoardMemoryMap
+{
+public:
+    BoardMemoryMap();
+
+    void setDefaults();
+    bool load(QString fileName);
+    static QString defaultFileName();
+
+    bool hasRegion(QString name) const;
+    MemoryRegion region(QString name) const;
+    QList<MemoryRegion> regions() const;
+    void setRegion(const MemoryRegion & region);
+
+    // returns the region containing the given address, or an invalid
+    // region if none does
+    MemoryRegion regionForAddress(quint32 address) const;
+
+    int addressBits() const;
+    void setAddressBits(int bits);
+    quint32 maxAddress() const;
+
+    bool hasChecksumUnit() const;
+    quint32 checksumAddress() const;
+
+    CompletionCriteria completionCriteria() const;
+
+protected:
+    static bool parseNumber(QString str, quint32 &value);
+    static int parseAccess(QString str);
+
+    QMap<QString, MemoryRegion> m_regions;
+    int m_addressBits;
+    bool m_hasChecksumUnit;
+    quint32 m_checksumAddress;
+
+    // raw [completion] settings, missing keys are derived from ex1.dmem
+    QMap<QString, quint32> m_completion;
+};
+
+#endif // BOARDMEMORYMAP_H
@@ -0,0 +1,231 @@
+#include <QFile>
+#include <QDebug>
+#include <QtEndian>
+#include "elfimage.h"
+
+// ELF constants used by the loader
+#define ELF_CLASS32         1
+#define ELF_DATA2LSB        1
+#define ELF_DATA2MSB        2
+#define ELF_EM_MIPS         8
+#define ELF_SHT_PROGBITS    1
+#define ELF_SHT_SYMTAB      2
+#define ELF_SHT_NOBITS      8
+#define ELF_SHF_ALLOC       0x2
+#define ELF_SHF_EXECINSTR   0x4
+#define ELF_SHN_LORESERVE   0xff00
+
+const int ELF_HEADER_SIZE = 52;
+const int ELF_SECTION_HEADER_SIZE = 40;
+const int ELF_SYMBOL_SIZE = 16;
+
+ElfImage::ElfImage()
+{
+    m_bigEndian = false;
+}
+
+bool ElfImage::isElf(const QString &fileName)
+{
+    QFile f(fileName);
+    return f.open(QIODevice::ReadOnly) && f.read(4) == QByteArray("\x7f" "ELF");
+}
+
+bool ElfImage::load(const QString &fileName, quint32 textBase, quint32 dataBase, quint32 dataSize)
+{
+    QFile f(fileName);
+    if(!f.open(QIODevice::ReadOnly))
+        return fail("could not open " + fileName);
+
+    return load(&f, textBase, dataBase, dataSize);
+}
+
+bool ElfImage::load(QIODevice *device, quint32 textBase, quint32 dataBase, quint32 dataSize)
+{
+    clear();
+
+    QByteArray header;
+    if(!readAt(device, 0, ELF_HEADER_SIZE, header) || !header.startsWith("\x7f" "ELF"))
+        return fail("not an ELF file");
+
+    const char * h = header.constData();
+    if(h[4] != ELF_CLASS32)
+        return fail("not a 32-bit ELF file");
+    if(h[5] != ELF_DATA2LSB && h[5] != ELF_DATA2MSB)
+        return fail("unknown byte order");
+    m_bigEndian = (h[5] == ELF_DATA2MSB);
+
+    if(half(h + 18) != ELF_EM_MIPS)
+        return fail("not a MIPS executable");
+
+    quint32 sectionOffset = word(h + 32);
+    int sectionEntrySize = half(h + 46);
+    int sectionCount = half(h + 48);
+    if(sectionCount == 0 || sectionEntrySize < ELF_SECTION_HEADER_SIZE)
+        return fail("no section headers");
+
+    QByteArray table;
+    if(!readAt(device, sectionOffset, sectionCount * sectionEntrySize, table))
+        return fail("truncated section headers");
+
+    QList<Section> sections;
+    for(int i = 0; i < sectionCount; i++)
+    {
+        const char * p = table.constData() + i * sectionEntrySize;
+        Section s;
+        s.name = word(p);
+        s.type = word(p + 4);
+        s.flags = word(p + 8);
+        s.address = word(p + 12);
+        s.offset = word(p + 16);
+        s.size = word(p + 20);
+        s.link = word(p + 24);
+        s.entrySize = word(p + 36);
+        sections.append(s);
+    }
+
+    // only program contents are placed; sections like .reginfo or
+    // .MIPS.abiflags are allocated too, but are meant for the loader
+    QMap<quint32, int> textSections, dataSections;      // index by linked address
+    for(int i = 0; i < sections.size(); i++)
+    {
+        const Section & s = sections.at(i);
+        if(!(s.flags & ELF_SHF_ALLOC) || s.size == 0 || (s.type != ELF_SHT_PROGBITS && s.type != ELF_SHT_NOBITS))
+            continue;
+        if(s.flags & ELF_SHF_EXECINSTR)
+            textSections.insertMulti(s.address, i);
+        else
+            dataSections.insertMulti(s.address, i);
+    }
+
+    // each group is moved as a whole and keeps its linked layout, since
+    // the code addresses the data at its linked offsets (lui/addiu pairs,
+    // $gp-relative accesses) and nothing is relocated
+    QMap<int, qint64> relocation;       // by section index
+    if(!textSections.isEmpty())
+    {
+        quint32 textStart = textSections.firstKey();
+        foreach(int i, textSections)
+            relocation[i] = (qint64) textBase - textStart;
+    }
+    if(!dataSections.isEmpty())
+    {
+        quint32 dataStart = dataSections.firstKey();
+        qint64 dataEnd = dataStart;
+        foreach(int i, dataSections)
+            dataEnd = qMax(dataEnd, (qint64) sections.at(i).address + sections.at(i).size);
+        if(dataEnd - dataStart > dataSize)
+            return fail(QString("the data sections span %1 bytes as linked, but the data memory holds %2")
+                        .arg(dataEnd - dataStart).arg(dataSize));
+
+        foreach(int i, dataSections)
+            relocation[i] = (qint64) dataBase - dataStart;
+    }
+
+    for(int i = 0; i < sections.size(); i++)
+    {
+        const Section & s = sections.at(i);
+
+        // NOBITS sections are zeroed at runtime and take no space in the file
+        if(!relocation.contains(i) || s.type != ELF_SHT_PROGBITS)
+            continue;
+
+        QByteArray contents;
+        if(!readAt(device, s.offset, s.size, contents))
+            return fail(QString("truncated section %1").arg(i));
+
+        if(m_bigEndian)
+        {
+            char * c = contents.data();
+            for(int j = 0; j + 4 <= contents.size(); j += 4)
+            {
+                qSwap(c[j], c[j + 3]);
+                qSwap(c[j + 1], c[j + 2]);
+            }
+        }
+
+        m_image.addData((quint32) (s.address + relocation[i]), contents);
+    }
+
+    // named symbols of the placed sections, at their board addresses
+    foreach(Section s, sections)
+    {
+        if(s.type != ELF_SHT_SYMTAB || s.link >= (quint32) sections.size())
+            continue;
+
+        QByteArray symbols, names;
+        const Section & strtab = sections.at(s.link);
+        if(!readAt(device, s.offset, s.size, symbols) || !readAt(device, strtab.offset, strtab.size, names))
+            return fail("truncated symbol table");
+
+        int entrySize = qMax((int) s.entrySize, ELF_SYMBOL_SIZE);
+        for(int j = 0; j + ELF_SYMBOL_SIZE <= symbols.size(); j += entrySize)
+        {
+            const char * p = symbols.constData() + j;
+            quint32 name = word(p);
+            int index = half(p + 14);
+            if(name == 0 || name >= (quint32) names.size() || index >= ELF_SHN_LORESERVE || !relocation.contains(index))
+                continue;
+
+            ElfSymbol sym((quint32) (word(p + 4) + relocation.value(index)), word(p + 8));
+            m_symbols.insert(QString::fromLatin1(names.constData() + name), sym);
+        }
+    }
+
+    return true;
+}
+
+QString ElfImage::errorString() const
+{
+    return m_errorString;
+}
+
+void ElfImage::clear()
+{
+    m_image.clear();
+    m_symbols.clear();
+    m_errorString.clear();
+}
+
+const MemoryImage & ElfImage::image() const
+{
+    return m_image;
+}
+
+bool ElfImage::hasSymbol(const QString &name) const
+{
+    return m_symbols.contains(name);
+}
+
+ElfSymbol ElfImage::symbol(const QString &name) const
+{
+    return m_symbols.value(name);
+}
+
+quint16 ElfImage::half(const char *p) const
+{
+    const uchar * u = (const uchar *) p;
+    return m_bigEndian ? qFromBigEndian<quint16>(u) : qFromLittleEndian<quint16>(u);
+}
+
+quint32 ElfImage::word(const char *p) const
+{
+    const uchar * u = (const uchar *) p;
+    return m_bigEndian ? qFromBigEndian<quint32>(u) : qFromLittleEndian<quint32>(u);
+}
+
+bool ElfImage::readAt(QIODevice *device, quint32 offset, quint32 size, QByteArray &out)
+{
+    if(!device->seek(offset))
+        return false;
+
+    out = device->read(size);
+    return out.size() == (int) size;
+}
+
+bool ElfImage::fail(QString message)
+{
+    qDebug() << "ELF loader:" << message;
+    clear();
+    m_errorString = message;
+    return false;
+}
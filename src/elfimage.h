@@ -0,0 +1,80 @@
+#ifndef ELFIMAGE_H
+#define ELFIMAGE_H
+
+#include <QIODevice>
+#include <QMap>
+#include <QString>
+#include "memoryimage.h"
+
+// symbols by which a program may locate its result and completion flag,
+// overriding the completion criteria of the memory map
+#define TDT4255_SYMBOL_RESULT   "result"
+#define TDT4255_SYMBOL_DONE     "done"
+
+// symbol of an ELF file, at its board address
+struct ElfSymbol
+{
+    ElfSymbol(quint32 address = 0, quint32 size = 0) : address(address), size(size) {}
+
+    quint32 address;
+    quint32 size;
+};
+
+/*
+ ElfImage loads 32-bit MIPS ELF executables for the Ex1 processor. The
+ executable sections (.text) are placed at textBase, the other program
+ sections (.rodata, .data, .sdata, .bss, ...) at dataBase, each group as a
+ whole so that it keeps the layout it was linked with; the code is not
+ relocated and still addresses the data at its linked offsets. Files whose
+ data sections span more than dataSize bytes are rejected. Only sections
+ with contents are put into the image; .bss and other NOBITS sections are
+ not transferred, but symbols in them are still resolved. Loader sections
+ like .reginfo are skipped.
+
+ The header, the section headers and the symbol table are read first, then
+ each loadable section is read on its own, so the file is never loaded as a
+ whole. The board memories hold little-endian words, so the words of
+ big-endian executables are byte-swapped.
+*/
+class ElfImage
+{
+public:
+    ElfImage();
+
+    static bool isElf(const QString & fileName);
+
+    bool load(const QString & fileName, quint32 textBase, quint32 dataBase, quint32 dataSize);
+    bool load(QIODevice * device, quint32 textBase, quint32 dataBase, quint32 dataSize);
+    QString errorString() const;
+    void clear();
+
+    const MemoryImage & image() const;
+
+    bool hasSymbol(const QString & name) const;
+    ElfSymbol symbol(const QString & name) const;
+
+private:
+    struct Section
+    {
+        quint32 name;
+        quint32 type;
+        quint32 flags;
+        quint32 address;
+        quint32 offset;
+        quint32 size;
+        quint32 link;
+        quint32 entrySize;
+    };
+
+    quint16 half(const char * p) const;
+    quint32 word(const char * p) const;
+    bool readAt(QIODevice * device, quint32 offset, quint32 size, QByteArray & out);
+    bool fail(QString message);
+
+    bool m_bigEndian;
+    MemoryImage m_image;
+    QMap<QString, ElfSymbol> m_symbols;
+    QString m_errorString;
+};
+
+#endif // ELFIMAGE_H
@@ -0,0 +1,131 @@
+#include <QDebug>
+#include <QThread>
+#include <QElapsedTimer>
+#include <QCoreApplication>
+#include "ex1runner.h"
+
+// back-off limits for polling the sentinel, in milliseconds
+const int MIN_POLL_INTERVAL = 1;
+const int MAX_POLL_INTERVAL = 64;
+
+Ex1Runner::Ex1Runner(TDT4255Board *board, QObject *parent) :
+    QObject(parent)
+{
+    m_board = board;
+    m_lastRunTime = 0;
+    m_lastPollCount = 0;
+}
+
+Ex1Runner::Result Ex1Runner::runToCompletion(const CompletionCriteria &criteria, QByteArray &result)
+{
+    m_lastRunTime = 0;
+    m_lastPollCount = 0;
+
+    // the sentinel is cleared before the run, which must not hit user data
+    if(!criteria.hasSentinel)
+    {
+        qDebug() << "runToCompletion: no sentinel configured";
+        return NoSentinel;
+    }
+
+    // events are processed while polling, keep the sampler and hotplug
+    // handling off the link until the run is over
+    m_board->lockLink();
+    Result res = run(criteria, result);
+    m_board->unlockLink();
+
+    return res;
+}
+
+Ex1Runner::Result Ex1Runner::run(const CompletionCriteria &criteria, QByteArray &result)
+{
+
+    // clear the sentinel so that a stale value from a previous run is not
+    // taken for completion, and start the processor in the same batch
+    QList<BoardOperation> ops;
+    ops << BoardOperation::write(criteria.sentinelAddress, QByteArray(criteria.sentinelWidth, 0))
+        << BoardOperation::write(TDT4255_EX1_REGADR_ENABPROC, QByteArray(1, 1));
+
+    if(!m_board->executeTransaction(ops, false))
+        return BoardError;
+
+    QElapsedTimer clock;
+    clock.start();
+
+    // the first poll is immediate, since most lab programs finish within
+    // a single round trip
+    int interval = 0;
+    bool reached = false;
+
+    while(true)
+    {
+        m_lastPollCount++;
+        if(!sentinelReached(criteria, reached))
+        {
+            stopProcessor();
+            return BoardError;
+        }
+
+        if(reached)
+            break;
+
+        if(clock.elapsed() > criteria.timeout)
+        {
+            qDebug() << "runToCompletion: no completion after" << clock.elapsed() << "ms, stopping processor";
+            m_lastRunTime = clock.elapsed();
+            stopProcessor();
+            return TimedOut;
+        }
+
+        QThread::msleep(interval);
+        QCoreApplication::processEvents(QEventLoop::ExcludeUserInputEvents);
+
+        interval = qBound(MIN_POLL_INTERVAL, interval * 2, MAX_POLL_INTERVAL);
+    }
+
+    m_lastRunTime = clock.elapsed();
+
+    // stop the processor and pull back the result range in one batch
+    ops.clear();
+    ops << BoardOperation::write(TDT4255_EX1_REGADR_ENABPROC, QByteArray(1, 0))
+        << BoardOperation::read(criteria.resultAddress, criteria.resultSize);
+
+    if(!m_board->executeTransaction(ops))
+        return BoardError;
+
+    result = ops.at(1).data;
+    return Completed;
+}
+
+qint64 Ex1Runner::lastRunTime()
+{
+    return m_lastRunTime;
+}
+
+int Ex1Runner::lastPollCount()
+{
+    return m_lastPollCount;
+}
+
+bool Ex1Runner::sentinelReached(const CompletionCriteria &criteria, bool &reached)
+{
+    QList<BoardOperation> ops;
+    ops << BoardOperation::read(criteria.sentinelAddress, criteria.sentinelWidth);
+
+    if(!m_board->executeTransaction(ops, false))
+        return false;
+
+    // words are stored little-endian
+    const QByteArray & word = ops.at(0).data;
+    quint32 val = 0;
+    for(int i = word.size() - 1; i >= 0; i--)
+        val = (val << 8) | (quint8) word.at(i);
+
+    reached = ((val & criteria.sentinelMask) == criteria.sentinelValue);
+    return true;
+}
+
+bool Ex1Runner::stopProcessor()
+{
+    return m_board->writeRegister(TDT4255_EX1_REGADR_ENABPROC, 0);
+}
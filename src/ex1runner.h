@@ -0,0 +1,39 @@
+#ifndef EX1RUNNER_H
+#define EX1RUNNER_H
+
+#include <QObject>
+#include "tdt4255board.h"
+
+// Runs an Ex1 program until it signals completion through a sentinel word
+// (see CompletionCriteria), then stops the processor and reads back only
+// the result range. The sentinel is polled with exponential back-off, so
+// short programs are detected within a round trip while long ones do not
+// keep the link busy.
+class Ex1Runner : public QObject
+{
+    Q_OBJECT
+public:
+    enum Result { Completed, TimedOut, BoardError, NoSentinel };
+
+    explicit Ex1Runner(TDT4255Board * board, QObject *parent = 0);
+
+    // the instruction and data memories must already be loaded. The link
+    // is locked for the whole run, see TDT4255Board::lockLink()
+    Result runToCompletion(const CompletionCriteria & criteria, QByteArray & result);
+
+    // duration of the last run from start until completion was detected,
+    // in milliseconds
+    qint64 lastRunTime();
+    int lastPollCount();
+
+private:
+    Result run(const CompletionCriteria & criteria, QByteArray & result);
+    bool sentinelReached(const CompletionCriteria & criteria, bool & reached);
+    bool stopProcessor();
+
+    TDT4255Board * m_board;
+    qint64 m_lastRunTime;
+    int m_lastPollCount;
+};
+
+#endif // EX1RUNNER_H
@@ -15,18 +15,64 @@ TEMPLATE = app
 SOURCES += main.cpp\
         mainwindow.cpp \
     tdt4255board.cpp \
+    boardhotplugmonitor.cpp \
+    boardmemorymap.cpp \
+    registersampler.cpp \
+    sampleplotwidget.cpp \
+    ex1runner.cpp \
+    memorydiff.cpp \
+    snapshothistory.cpp \
+    mipsdisasm.cpp \
+    memoryimage.cpp \
+    elfimage.cpp \
+    batchrunner.cpp \
+    resultcache.cpp \
+    rpncompiler.cpp \
+    QHexEdit/changebitmap.cpp \
     QHexEdit/commands.cpp \
+    QHexEdit/hexdumpwriter.cpp \
+    QHexEdit/piecetable.cpp \
     QHexEdit/qhexedit.cpp \
     QHexEdit/qhexedit_p.cpp \
+    QHexEdit/searchpattern.cpp \
+    QHexEdit/undostack.cpp \
     QHexEdit/xbytearray.cpp
 
 HEADERS  += mainwindow.h \
     tdt4255board.h \
+    boardhotplugmonitor.h \
+    boardmemorymap.h \
+    registersampler.h \
+    sampleringbuffer.h \
+    sampleplotwidget.h \
+    ex1runner.h \
+    memorydiff.h \
+    snapshothistory.h \
+    mipsdisasm.h \
+    memoryimage.h \
+    elfimage.h \
+    batchrunner.h \
+    resultcache.h \
+    rpncompiler.h \
+    QHexEdit/changebitmap.h \
     QHexEdit/commands.h \
+    QHexEdit/hexdumpwriter.h \
+    QHexEdit/piecetable.h \
     QHexEdit/qhexedit.h \
     QHexEdit/qhexedit_p.h \
+    QHexEdit/searchpattern.h \
+    QHexEdit/undostack.h \
     QHexEdit/xbytearray.h
 
 INCLUDEPATH += QHexEdit
 
+# uncomment to log the average QHexEdit paint time every 100 frames
+#DEFINES += QHEXEDIT_PAINT_BENCHMARK
+
+# udev is used for board hotplug detection on Linux
+linux {
+    LIBS += -ludev
+    DEFINES += TDT4255_HAVE_UDEV
+}
+
 FORMS    += mainwindow.ui
@@ -1,16 +1,86 @@
 #include <QDebug>
+#include <QCommandLineParser>
+#include <QFile>
+#include <QTextStream>
 #include "tdt4255board.h"
+#include "batchrunner.h"
+#include "resultcache.h"
 #include "mainwindow.h"
 #include <QApplication>
 
+// runs a manifest of Ex1 jobs without the GUI, see BatchRunner
+static int runBatch(const QCommandLineParser & parser)
+{
+    QTextStream out(stdout);
+    TDT4255Board * board = TDT4255Board::getInstance();
+    board->loadMemoryMap(BoardMemoryMap::defaultFileName());
+
+    BatchRunner runner(board);
+    if(!runner.loadManifest(parser.value("batch")))
+    {
+        out << "could not load manifest: " << runner.errorString() << endl;
+        return 2;
+    }
+    runner.setBitfile(parser.value("bitfile"));
+
+    ResultCache cache;
+    if(parser.isSet("clear-cache") && !cache.clear())
+        out << "could not clear the result cache " << ResultCache::defaultDirectory() << endl;
+    if(parser.isSet("no-cache"))
+        cache.setMode(ResultCache::Disabled);
+    else if(parser.isSet("refresh-cache"))
+        cache.setMode(ResultCache::Refresh);
+    runner.setResultCache(&cache);
+
+    runner.run();
+
+    foreach(BatchResult r, runner.results())
+        out << r.name << ": " << r.statusString() << (r.cached ? " (cached)" : "") << " in " << r.totalTime << " ms " << r.message << endl;
+    out << QString("%1 of %2 jobs passed in %3 s, %4 jobs/min")
+           .arg(runner.passedCount()).arg(runner.results().size())
+           .arg(runner.totalTime() / 1000.0, 0, 'f', 1).arg(runner.jobsPerMinute(), 0, 'f', 1) << endl;
+    if(cache.hits() > 0)
+        out << cache.hits() << " results taken from the cache" << endl;
+
+    QString report = parser.value("report");
+    if(!report.isEmpty())
+    {
+        QFile f(report);
+        if(!f.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text) || !runner.writeReport(&f))
+        {
+            out << "could not write report " << report << endl;
+            return 2;
+        }
+    }
+
+    return (runner.passedCount() == runner.results().size()) ? 0 : 1;
+}
+
 int main(int argc, char *argv[])
 {
     QApplication a(argc, argv);
 
-    MainWindow w;
-    w.show();
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    QCommandLineOption batchOption("batch", "Run the Ex1 jobs of <manifest> unattended and exit.", "manifest");
+    parser.addOption(batchOption);
+    parser.addOption(QCommandLineOption("report", "Write the batch results to <csv>.", "csv"));
+    parser.addOption(QCommandLineOption("bitfile", "Flash <bitfile> before the batch, and cache its results.", "bitfile"));
+    parser.addOption(QCommandLineOption("no-cache", "Neither use nor store cached batch results."));
+    parser.addOption(QCommandLineOption("refresh-cache", "Run every batch job on the board and store the fresh results."));
+    parser.addOption(QCommandLineOption("clear-cache", "Remove all cached batch results first."));
+    parser.process(a);
+
+    int ret;
+    if(parser.isSet(batchOption))
+        ret = runBatch(parser);
+    else
+    {
+        MainWindow w;
+        w.show();
 
-    int ret = a.exec();
+        ret = a.exec();
+    }
 
     TDT4255Board::destroyInstance();
 
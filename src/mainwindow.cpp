@@ -1,10 +1,72 @@
 #include <QFileDialog>
+#include <QFileInfo>
+#include <QInputDialog>
 #include <QMessageBox>
+#include <QRegExp>
+#include <QShortcut>
+#include <QSlider>
+#include <QTime>
 #include <QDebug>
 #include "QHexEdit/qhexedit.h"
+#include "elfimage.h"
+#include "memorydiff.h"
+#include "memoryimage.h"
+#include "mipsdisasm.h"
+#include "rpncompiler.h"
 #include "mainwindow.h"
 #include "ui_mainwindow.h"
 
+// words are stored little-endian in the board memories; the word is read
+// straight from the view into a local buffer, so decoding it on every cursor
+// move allocates nothing. Returns the number of bytes read (at most 8).
+static int readWord(QHexEdit *view, int pos, int wordWidth, quint64 &word)
+{
+    char bytes[8];
+    int size = view->read(pos, qMin(wordWidth, 8), bytes);
+
+    word = 0;
+    for(int i = size - 1; i >= 0; i--)
+        word = (word << 8) | (quint8) bytes[i];
+
+    return size;
+}
+
+static qint64 wordToSigned(quint64 word, int size)
+{
+    if(size == 0)
+        return 0;
+
+    // sign-extend words narrower than 64 bits
+    qint64 val = (qint64) word;
+    int bits = 8 * size;
+    if(bits < 64 && (val & (Q_INT64_C(1) << (bits - 1))))
+        val -= (Q_INT64_C(1) << bits);
+
+    return val;
+}
+
+static QString wordToHex(quint64 word, int size)
+{
+    if(size == 0)
+        return QString();
+
+    return QString("%1").arg(word, 2 * size, 16, QChar('0'));
+}
+
+static const char * const memoryFileFilter =
+        "All files (*);;Intel HEX (*.hex *.ihx);;Motorola S-record (*.srec *.s19 *.s28 *.s37 *.mot);;ELF executable (*.elf)";
+
+// decoders for the word area of the memory displays
+static QString decodeSignedWord(quint32 word, int)
+{
+    return QString::number((qint32) word);
+}
+
+static QString decodeInstruction(quint32 word, int address)
+{
+    return MipsDisassembler::disassemble(word, address);
+}
+
 MainWindow::MainWindow(QWidget *parent) :
     QMainWindow(parent),
     ui(new Ui::MainWindow)
@@ -14,18 +76,40 @@ MainWindow::MainWindow(QWidget *parent) :
     ui->lstInstructions->viewport()->installEventFilter(this);
     ui->lstInstructions->installEventFilter(this);
 
-    QByteArray emptyMemData(256, 0);
+    m_board = TDT4255Board::getInstance();
+
+    // region sizes and addresses come from the memory map descriptor,
+    // if there is one next to the executable
+    m_board->loadMemoryMap(BoardMemoryMap::defaultFileName());
 
-    ui->dataMemDisplay->setData(emptyMemData);
-    ui->instMemDisplay->setData(emptyMemData);
+    MemoryRegion instRegion = memRegion(TDT4255_REGION_EX1_INSMEM);
+    MemoryRegion dataRegion = memRegion(TDT4255_REGION_EX1_DATMEM);
+
+    ui->dataMemDisplay->setData(QByteArray(dataRegion.size, 0));
+    ui->instMemDisplay->setData(QByteArray(instRegion.size, 0));
+
+    ui->btnReadInst->setEnabled(instRegion.isReadable());
+    ui->btnWriteInst->setEnabled(instRegion.isWritable());
+    ui->btnReadData->setEnabled(dataRegion.isReadable());
+    ui->btnWriteData->setEnabled(dataRegion.isWritable());
 
-    m_board = TDT4255Board::getInstance();
     connect(m_board, SIGNAL(bufferOperationProgress(int,int)),this,SLOT(bufferOperationProgress(int,int)));
     connect(m_board, SIGNAL(bitfileOperationProgress(int,int)),this,SLOT(bitfileOperationProgress(int,int)));
     connect(m_board, SIGNAL(connStatusChange(bool)), this, SLOT(connStatusChanged(bool)));
+    connect(m_board, SIGNAL(boardAttached()), this, SLOT(boardAttached()));
+    connect(m_board, SIGNAL(boardDetached()), this, SLOT(boardDetached()));
 
     m_board->connectToBoard();
 
+    m_ex1Runner = new Ex1Runner(m_board, this);
+
+    m_sampler = new RegisterSampler(m_board, this);
+    ui->plotSamples->setSampler(m_sampler);
+    connect(m_sampler, SIGNAL(started()), this, SLOT(samplingStateChanged()));
+    connect(m_sampler, SIGNAL(stopped()), this, SLOT(samplingStateChanged()));
+    connect(m_board, SIGNAL(boardDetached()), m_sampler, SLOT(stop()));
+    samplingStateChanged();
+
     // set options for the data memory display
     QHexEdit *hexEdit = ui->dataMemDisplay;
     connect(hexEdit, SIGNAL(currentAddressChanged(int)), this, SLOT(selDataAddrChanged(int)));
@@ -42,6 +126,7 @@ MainWindow::MainWindow(QWidget *parent) :
     hexEdit->setFont(QFont("Courier", 10));
 
     hexEdit->setAddressWidth(4);
+    hexEdit->setWordDecoder(decodeSignedWord, 11);
 
     // set options for the instruction memory display
     hexEdit = ui->instMemDisplay;
@@ -59,7 +144,11 @@ MainWindow::MainWindow(QWidget *parent) :
     hexEdit->setFont(QFont("Courier", 10));
 
     hexEdit->setAddressWidth(4);
+    hexEdit->setWordDecoder(decodeInstruction, MipsDisassembler::MAX_LENGTH);
 
+    // pattern search in whichever memory display has the focus
+    new QShortcut(QKeySequence::Find, this, SLOT(findInMemory()));
+    new QShortcut(QKeySequence::FindNext, this, SLOT(findNextInMemory()));
 }
 
 MainWindow::~MainWindow()
@@ -100,10 +189,150 @@ void MainWindow::connStatusChanged(bool status)
         ui->lblBoardConnStatus->setText("Disconnected");
 }
 
+MemoryRegion MainWindow::memRegion(QString name)
+{
+    return m_board->memoryMap().region(name);
+}
+
+void MainWindow::showMemory(QHexEdit *view, const QByteArray &mem)
+{
+    restoreLiveView(view);
+
+    // highlight what differs from the previously displayed contents,
+    // e.g what a program run has changed
+    QList<DiffRange> diff = MemoryDiff::compare(view->data(), mem);
+
+    view->setData(mem);
+    m_imageViews.removeAll(view);
+    foreach(DiffRange r, diff)
+        view->setDataChanged(r.offset, r.length);
+
+    // keep the readback in the history of the view, and move the
+    // scrubber to it
+    bool isInst = (view == ui->instMemDisplay);
+    SnapshotHistory & history = isInst ? m_instHistory : m_dataHistory;
+    QSlider * slider = isInst ? ui->sldInstHistory : ui->sldDataHistory;
+
+    history.append(mem, "read " + QTime::currentTime().toString());
+
+    slider->blockSignals(true);
+    slider->setMaximum(history.count() - 1);
+    slider->setValue(history.count() - 1);
+    slider->blockSignals(false);
+    slider->setToolTip(history.label(history.count() - 1));
+}
+
+void MainWindow::showSnapshot(QHexEdit *view, SnapshotHistory &history, QSlider *slider, int index)
+{
+    if(index < 0 || index >= history.count())
+        return;
+
+    slider->setToolTip(QString("%1 (%2 of %3)").arg(history.label(index)).arg(index + 1).arg(history.count()));
+
+    // the newest position shows the live, editable contents
+    if(index == history.count() - 1)
+    {
+        restoreLiveView(view);
+        return;
+    }
+
+    // past snapshots are only for viewing, the live contents are put
+    // aside until the view is written, read or scrubbed back
+    if(!m_liveViews.contains(view))
+    {
+        LiveView live;
+        live.data = view->data();
+        live.isImage = m_imageViews.contains(view);
+        int runLength = 0;
+        for(int pos = view->indexOfChanged(0, &runLength); pos >= 0; pos = view->indexOfChanged(pos + runLength, &runLength))
+            live.changed.append(DiffRange(pos, runLength));
+        m_liveViews.insert(view, live);
+        m_imageViews.removeAll(view);
+        view->setReadOnly(true);
+    }
+
+    view->setData(history.snapshot(index));
+    foreach(DiffRange r, history.changes(index))
+        view->setDataChanged(r.offset, r.length);
+}
+
+void MainWindow::restoreLiveView(QHexEdit *view)
+{
+    if(!m_liveViews.contains(view))
+        return;
+
+    LiveView live = m_liveViews.take(view);
+    view->setData(live.data);
+    foreach(DiffRange r, live.changed)
+        view->setDataChanged(r.offset, r.length);
+    if(live.isImage)
+        m_imageViews.append(view);
+    view->setReadOnly(false);
+
+    QSlider * slider = (view == ui->instMemDisplay) ? ui->sldInstHistory : ui->sldDataHistory;
+    slider->blockSignals(true);
+    slider->setValue(slider->maximum());
+    slider->blockSignals(false);
+}
+
+void MainWindow::boardAttached()
+{
+    if(!ui->chkReverifyOnAttach->isChecked())
+        return;
+
+    // re-verify the exercise frameworks and bring the displayed
+    // state back in sync with the board
+    on_btnCheckConnEx0_clicked();
+    on_btnCheckConnEx1_clicked();
+
+    if(ui->grpProcControl->isEnabled())
+        updateAllRegisters();
+
+    if(ui->grpEx1ProcCtrl->isEnabled())
+    {
+        on_btnReadInst_clicked();
+        on_btnReadData_clicked();
+    }
+}
+
+void MainWindow::boardDetached()
+{
+    // nothing can be done until the board comes back
+    ui->lblConnectionStatusEx0->setText("Exercise framework status: Disconnected");
+    ui->grpProcControl->setEnabled(false);
+
+    ui->lblConnectionStatusEx1->setText("Exercise framework status: Disconnected");
+    ui->grpEx1DataMem->setEnabled(false);
+    ui->grpEx1InstMem->setEnabled(false);
+    ui->grpEx1ProcCtrl->setEnabled(false);
+}
+
 void MainWindow::updateAllRegisters()
 {
-    // call all register read handlers
-    on_btnReadStackTop_clicked();
+    refreshRegisters(QList<BoardOperation>());
+}
+
+void MainWindow::refreshRegisters(QList<BoardOperation> operations)
+{
+    // read all registers in the same batch as the given operations,
+    // instead of one round trip per register
+    int firstRead = operations.size();
+    operations << BoardOperation::read(TDT4255_EX0_REGADR_STACKTOP, 1)
+               << BoardOperation::read(TDT4255_EX0_REGADR_INSTLEFT, 1)
+               << BoardOperation::read(TDT4255_EX0_REGADR_INSTPNTR, 1);
+
+    if(m_board->executeTransaction(operations))
+    {
+        ui->txtStackTop->setText(QString::number((qint8) operations.at(firstRead).data.at(0)));
+        ui->txtInstLeft->setText(QString::number((quint8) operations.at(firstRead + 1).data.at(0)));
+        ui->txtInstPntr->setText(QString::number((quint8) operations.at(firstRead + 2).data.at(0)));
+    }
+    else
+    {
+        ui->txtStackTop->setText("error!");
+        ui->txtInstLeft->setText("error!");
+        ui->txtInstPntr->setText("error!");
+    }
 }
 
 void MainWindow::bufferOperationProgress(int current, int max)
@@ -124,54 +353,50 @@ void MainWindow::bitfileOperationProgress(int current, int max)
 
 void MainWindow::on_btnConvertInstrs_clicked()
 {
-    QString expr = ui->txtRPNExpression->text();
+    // the expression is appended to the program, which is compiled as a
+    // whole so that it may use the values left by earlier expressions
+    QString source = m_programSource + " " + ui->txtRPNExpression->text();
+    if(compileProgram(source))
+        m_programSource = source;
+}
 
-    QStringList elems = expr.split(" ");
+void MainWindow::on_chkFoldConstants_toggled(bool)
+{
+    compileProgram(m_programSource);
+}
 
-    if(ui->lstInstructions->count() + elems.size() > 256)
+bool MainWindow::compileProgram(const QString &source)
+{
+    RpnCompiler compiler;
+    compiler.setFoldConstants(ui->chkFoldConstants->isChecked());
+    if(!compiler.compile(source))
     {
-        QMessageBox::critical(this, "Error", "Too many instructions (max 256)");
-        return;
+        QMessageBox::critical(this, "Error", compiler.errorString());
+        return false;
     }
 
-    // create instruction buffer while adding QListWidget entries
+    // each instruction occupies 16 bits of program memory
+    int maxInstrs = memRegion(TDT4255_REGION_EX0_PROGRAM).size / sizeof(quint16);
 
-    foreach(QString elem, elems)
+    if(compiler.program().size() > maxInstrs)
     {
-        if(elem == "+")
-        {
-            ui->lstInstructions->addItem("ADD");
-            m_programData.append(0x0100);
-        }
-        else if (elem == "-")
-        {
-            ui->lstInstructions->addItem("SUB");
-            m_programData.append(0x0200);
-        }
-        else if(elem.toInt() != 0)
-        {
-            if(elem.toInt() < -128 || elem.toInt() > 127)
-            {
-                QMessageBox::critical(this, "Error", "Values must be in range [-128, 127]");
-                return;
-            }
-            ui->lstInstructions->addItem("PUSH "+ elem);
-            m_programData.append((quint16)(quint8)elem.toInt());
-        }
-        else
-        {
-            QMessageBox::critical(this, "Error", "Unrecognized symbol: " + elem);
-            return;
-        }
+        QMessageBox::critical(this, "Error", "Too many instructions (max " + QString::number(maxInstrs) + ")");
+        return false;
     }
 
-    ui->lblInstrCount->setText("Instructions: (count = " + QString::number(ui->lstInstructions->count()) + ")");
+    m_programData = compiler.program();
+    ui->lstInstructions->clear();
+    ui->lstInstructions->addItems(compiler.listing());
+    ui->lblInstrCount->setText("Instructions: (count = " + QString::number(m_programData.size())
+                               + ", stack depth = " + QString::number(compiler.maxStackDepth()) + ")");
+    return true;
 }
 
 void MainWindow::on_btnClrInstrs_clicked()
 {
     ui->lstInstructions->clear();
     m_programData.clear();
+    m_programSource.clear();
     ui->lblInstrCount->setText("Instructions: (count = 0)");
 }
 
@@ -197,22 +422,20 @@ void MainWindow::on_btnWriteProgram_clicked()
 
     //qDebug() << programBytes.toHex();
 
-    if(!m_board->writeBuffer(TDT4255_EX0_PRGDAT_BASEADDR, programBytes))
-    {
-        QMessageBox::critical(this, "Error", "Could not write program data");
-        return;
-    }
+    quint32 programBase = memRegion(TDT4255_REGION_EX0_PROGRAM).baseAddress;
 
-    // read and verify that program has been correctly written
-    QByteArray verifyBytes(programBytes.size(), 0);
-    if(!m_board->readBuffer(TDT4255_EX0_PRGDAT_BASEADDR, verifyBytes))
+    if(!m_board->writeBuffer(programBase, programBytes))
     {
-        QMessageBox::critical(this, "Error", "Could not read to verify program data");
+        QMessageBox::critical(this, "Error", "Could not write program data");
         return;
     }
 
-    if(verifyBytes == programBytes)
-        QMessageBox::information(this, "Message", QString::number(m_programData.size())+ " instructions successfully programmed");
+    // verify by checksum where the framework computes one, otherwise
+    // by reading back a sample of the program
+    TDT4255Board::VerifyMode mode;
+    if(m_board->verifyBuffer(programBase, programBytes, TDT4255Board::VerifyChecksum, &mode))
+        QMessageBox::information(this, "Message", QString::number(m_programData.size())+ " instructions successfully programmed"
+                                 + (mode == TDT4255Board::VerifyChecksum ? " (CRC verified)" : ""));
     else
         QMessageBox::critical(this, "Error", "Program data written but not verified");
 }
@@ -220,29 +443,33 @@ void MainWindow::on_btnWriteProgram_clicked()
 void MainWindow::on_btnExecOne_clicked()
 {
     ui->lstInstructions->setCurrentRow(ui->lstInstructions->currentRow()+1);
-    m_board->writeRegister(TDT4255_EX0_REGADR_INSTLEFT, 0x01);
-    updateAllRegisters();
+
+    QList<BoardOperation> ops;
+    ops << BoardOperation::write(TDT4255_EX0_REGADR_INSTLEFT, QByteArray(1, 0x01));
+    refreshRegisters(ops);
 }
 
 void MainWindow::on_btnExecAll_clicked()
 {
-    m_board->writeRegister(TDT4255_EX0_REGADR_INSTLEFT, (quint8) m_programData.size());
-    updateAllRegisters();
+    QList<BoardOperation> ops;
+    ops << BoardOperation::write(TDT4255_EX0_REGADR_INSTLEFT, QByteArray(1, (char) m_programData.size()));
+    refreshRegisters(ops);
 
     ui->lstInstructions->setCurrentRow(ui->lstInstructions->count()-1);
 }
 
 void MainWindow::on_btnReset_clicked()
 {
+    QList<BoardOperation> ops;
     // reset on
-    m_board->writeRegister(TDT4255_EX0_REGADR_RESTPROC, 1);
+    ops << BoardOperation::write(TDT4255_EX0_REGADR_RESTPROC, QByteArray(1, 1));
     // set remaining instructions to zero
-    m_board->writeRegister(TDT4255_EX0_REGADR_INSTLEFT, 0);
+    ops << BoardOperation::write(TDT4255_EX0_REGADR_INSTLEFT, QByteArray(1, 0));
     // write FF to instruction pointer (workaround for not losing the first instruction)
-    m_board->writeRegister(TDT4255_EX0_REGADR_INSTPNTR, 0xFF);
+    ops << BoardOperation::write(TDT4255_EX0_REGADR_INSTPNTR, QByteArray(1, (char) 0xFF));
     // reset off
-    m_board->writeRegister(TDT4255_EX0_REGADR_RESTPROC, 0);
-    updateAllRegisters();
+    ops << BoardOperation::write(TDT4255_EX0_REGADR_RESTPROC, QByteArray(1, 0));
+    refreshRegisters(ops);
 
     // clear selection from UI list
     ui->lstInstructions->clearSelection();
@@ -324,32 +551,223 @@ void MainWindow::on_btnCheckConnEx1_clicked()
 
 void MainWindow::on_btnLoadDataFromFile_clicked()
 {
-    QString fileName = QFileDialog::getOpenFileName(0, "Fill Data Memory", "", "");
+    QString fileName = QFileDialog::getOpenFileName(0, "Fill Data Memory", "", memoryFileFilter);
 
     if(!fileName.isEmpty())
-    {
-        QFile f(fileName);
-        f.open(QIODevice::ReadOnly);
-        QByteArray dat = f.readAll();
-        f.close();
-        dat.resize(256);
-        ui->dataMemDisplay->setData(dat);
-    }
+        loadMemoryFile(ui->dataMemDisplay, fileName, memRegion(TDT4255_REGION_EX1_DATMEM));
 }
 
 void MainWindow::on_btnLoadInstFromFile_clicked()
 {
-    QString fileName = QFileDialog::getOpenFileName(0, "Fill Instruction Memory", "", "");
+    QString fileName = QFileDialog::getOpenFileName(0, "Fill Instruction Memory", "", memoryFileFilter);
 
     if(!fileName.isEmpty())
+        loadMemoryFile(ui->instMemDisplay, fileName, memRegion(TDT4255_REGION_EX1_INSMEM));
+}
+
+QHexEdit * MainWindow::focusedMemoryView()
+{
+    QWidget * focus = focusWidget();
+    if(focus && ui->instMemDisplay->isAncestorOf(focus))
+        return ui->instMemDisplay;
+
+    return ui->dataMemDisplay;
+}
+
+void MainWindow::findInMemory()
+{
+    QHexEdit * view = focusedMemoryView();
+
+    bool ok;
+    QString pattern = QInputDialog::getText(this, "Find in memory",
+                                            "Hex pattern, ? matches any nibble (e.g. 8c ?? 00 2?):",
+                                            QLineEdit::Normal, m_searchPattern, &ok);
+    if(!ok)
+        return;
+
+    if(!view->setSearchPattern(pattern))
+    {
+        QMessageBox::warning(this, "Find in memory", "Invalid pattern: " + pattern);
+        return;
+    }
+
+    m_searchPattern = pattern;
+    if(pattern.trimmed().isEmpty())
+        return;
+
+    if(view->findNext(0) < 0)
+        QMessageBox::information(this, "Find in memory", "Pattern not found");
+}
+
+void MainWindow::findNextInMemory()
+{
+    QHexEdit * view = focusedMemoryView();
+
+    // the match after the one under the cursor
+    if(view->findNext(view->cursorPosition() + 1) < 0)
+        findInMemory();
+}
+
+void MainWindow::writeMemory(QHexEdit *view, const MemoryRegion &region)
+{
+    restoreLiveView(view);
+
+    // the board reads the bytes straight from the view, at most region.size
+    // of them, even if a larger file is shown
+    int len = qMin(view->dataSize(), (int) region.size);
+
+    if(!m_imageViews.contains(view))
+    {
+        m_board->writeBuffer(region.baseAddress, QByteArray::fromRawData(view->constData(), len));
+        return;
+    }
+
+    // a sparse image only writes its records and the bytes edited since,
+    // which are exactly the highlighted ones; holes are skipped
+    int runLength = 0;
+    for(int pos = view->indexOfChanged(0, &runLength); pos >= 0 && pos < len; pos = view->indexOfChanged(pos + runLength, &runLength))
+    {
+        int n = qMin(runLength, len - pos);
+        if(!m_board->writeBuffer(region.baseAddress + pos, QByteArray::fromRawData(view->constData() + pos, n)))
+            return;
+    }
+}
+
+void MainWindow::loadMemoryImage(const QString &fileName, const MemoryRegion &region)
+{
+    MemoryImage image;
+    if(!image.load(fileName))
+    {
+        QMessageBox::critical(this, "Error", "Could not load " + fileName + ": " + image.errorString());
+        return;
+    }
+
+    // images at board addresses fill every memory they cover, others are
+    // placed at the start of the chosen memory
+    MemoryRegion instRegion = memRegion(TDT4255_REGION_EX1_INSMEM);
+    MemoryRegion dataRegion = memRegion(TDT4255_REGION_EX1_DATMEM);
+    if(image.segmentsIn(instRegion).isEmpty() && image.segmentsIn(dataRegion).isEmpty())
+        image.relocate(region.baseAddress);
+
+    int placed = showImage(ui->instMemDisplay, image, instRegion) + showImage(ui->dataMemDisplay, image, dataRegion);
+    if(placed < image.byteCount())
+        QMessageBox::warning(this, "Memory image", QString("%1 of the %2 bytes in %3 lie outside the memories and were ignored.")
+                             .arg(image.byteCount() - placed).arg(image.byteCount()).arg(QFileInfo(fileName).fileName()));
+}
+
+void MainWindow::loadElf(const QString &fileName)
+{
+    // .text goes to the instruction memory and .data/.rodata to the data
+    // memory, only the sections with contents are written to the board. A
+    // memory the program has nothing for is cleared, so that no earlier
+    // contents are written along with it
+    MemoryRegion instRegion = memRegion(TDT4255_REGION_EX1_INSMEM);
+    MemoryRegion dataRegion = memRegion(TDT4255_REGION_EX1_DATMEM);
+    if(!m_program.load(fileName, instRegion.baseAddress, dataRegion.baseAddress, dataRegion.size))
+    {
+        QMessageBox::critical(this, "Error", "Could not load " + fileName + ": " + m_program.errorString());
+        return;
+    }
+
+    const MemoryImage & image = m_program.image();
+    int placed = showImage(ui->instMemDisplay, image, instRegion, true) + showImage(ui->dataMemDisplay, image, dataRegion, true);
+    if(placed < image.byteCount())
+        QMessageBox::warning(this, "ELF program", QString("%1 of the %2 bytes in %3 do not fit the memories and were ignored.")
+                             .arg(image.byteCount() - placed).arg(image.byteCount()).arg(QFileInfo(fileName).fileName()));
+}
+
+int MainWindow::showImage(QHexEdit *view, const MemoryImage &image, const MemoryRegion &region, bool clearUncovered)
+{
+    restoreLiveView(view);
+
+    QList<ImageSegment> segments = image.segmentsIn(region);
+    if(segments.isEmpty() && !clearUncovered)
+        return 0;
+
+    // holes read as zero, the records are highlighted
+    QByteArray mem(region.size, 0);
+    foreach(ImageSegment s, segments)
+        mem.replace(s.address - region.baseAddress, s.data.size(), s.data);
+
+    view->setData(mem);
+    int placed = 0;
+    foreach(ImageSegment s, segments)
+    {
+        view->setDataChanged(s.address - region.baseAddress, s.data.size());
+        placed += s.data.size();
+    }
+
+    if(!m_imageViews.contains(view))
+        m_imageViews.append(view);
+    return placed;
+}
+
+bool MainWindow::saveMemoryFile(QHexEdit *view, const QString &fileName, const MemoryRegion &region)
+{
+    MemoryImage::Format format = MemoryImage::formatForFile(fileName);
+    if(format == MemoryImage::Raw)
+        return view->saveFile(fileName);
+
+    // records are written at board addresses; views holding a sparse image
+    // keep its holes
+    MemoryImage image;
+    int len = qMin(view->dataSize(), (int) region.size);
+    if(m_imageViews.contains(view))
+    {
+        int runLength = 0;
+        for(int pos = view->indexOfChanged(0, &runLength); pos >= 0 && pos < len; pos = view->indexOfChanged(pos + runLength, &runLength))
+            image.addData(region.baseAddress + pos, view->dataAt(pos, qMin(runLength, len - pos)));
+    }
+    else
+        image.addData(region.baseAddress, view->dataAt(0, len));
+
+    return image.save(fileName, format);
+}
+
+void MainWindow::loadMemoryFile(QHexEdit *view, const QString &fileName, const MemoryRegion &region)
+{
+    if(ElfImage::isElf(fileName))
+    {
+        loadElf(fileName);
+        return;
+    }
+
+    // the symbols of an earlier program no longer describe the memories
+    m_program.clear();
+
+    if(MemoryImage::formatForFile(fileName) != MemoryImage::Raw)
+    {
+        loadMemoryImage(fileName, region);
+        return;
+    }
+
+    restoreLiveView(view);
+    m_imageViews.removeAll(view);
+
+    QFile f(fileName);
+    if(!f.open(QIODevice::ReadOnly))
+    {
+        QMessageBox::critical(this, "Error", "Could not open " + fileName);
+        return;
+    }
+
+    // files larger than the region, like full memory dumps or traces, are
+    // mapped instead of loaded; only the start is written to the board
+    if(f.size() > region.size)
     {
-        QFile f(fileName);
-        f.open(QIODevice::ReadOnly);
-        QByteArray dat = f.readAll();
         f.close();
-        dat.resize(256);
-        ui->instMemDisplay->setData(dat);
+        if(!view->openFile(fileName))
+            QMessageBox::critical(this, "Error", "Could not map " + fileName);
+        else
+            QMessageBox::information(this, "Large file", QString("%1 is larger than %2, only its first %3 bytes are written to the board.")
+                                     .arg(QFileInfo(fileName).fileName()).arg(region.name).arg(region.size));
+        return;
     }
+
+    QByteArray dat = f.readAll();
+    f.close();
+    dat.resize(region.size);
+    view->setData(dat);
 }
 
 void MainWindow::on_btnEx1ProcReset_clicked()
@@ -376,77 +794,193 @@ void MainWindow::on_btnEx1ProcStop_clicked()
     ui->grpEx1InstMem->setEnabled(true);
 }
 
+void MainWindow::on_btnEx1RunToCompletion_clicked()
+{
+    CompletionCriteria criteria = m_board->memoryMap().completionCriteria();
+    MemoryRegion dataRegion = memRegion(TDT4255_REGION_EX1_DATMEM);
+
+    // a loaded ELF program may locate its result and completion flag by symbol
+    if(m_program.hasSymbol(TDT4255_SYMBOL_RESULT))
+    {
+        ElfSymbol result = m_program.symbol(TDT4255_SYMBOL_RESULT);
+        criteria.resultAddress = result.address;
+        if(result.size > 0)
+            criteria.resultSize = result.size;
+    }
+    if(m_program.hasSymbol(TDT4255_SYMBOL_DONE))
+    {
+        criteria.sentinelAddress = m_program.symbol(TDT4255_SYMBOL_DONE).address;
+        criteria.hasSentinel = true;
+    }
+
+    // i/d memory should not be touched while processor is running
+    ui->grpEx1DataMem->setEnabled(false);
+    ui->grpEx1InstMem->setEnabled(false);
+    ui->lblEx1RunStatus->setText("Running...");
+
+    QByteArray result;
+    Ex1Runner::Result res = m_ex1Runner->runToCompletion(criteria, result);
+
+    ui->grpEx1DataMem->setEnabled(true);
+    ui->grpEx1InstMem->setEnabled(true);
+
+    switch(res)
+    {
+    case Ex1Runner::Completed:
+        if(dataRegion.contains(criteria.resultAddress, result.size()))
+        {
+            // only the result range was read back, merge it into the view
+            QByteArray mem = ui->dataMemDisplay->data();
+            mem.replace(criteria.resultAddress - dataRegion.baseAddress, result.size(), result);
+            showMemory(ui->dataMemDisplay, mem);
+        }
+        ui->lblEx1RunStatus->setText("Completed in " + QString::number(m_ex1Runner->lastRunTime()) + " ms");
+        break;
+    case Ex1Runner::TimedOut:
+        ui->lblEx1RunStatus->setText("Timed out, stopped");
+        break;
+    case Ex1Runner::BoardError:
+        ui->lblEx1RunStatus->setText("Board error");
+        QMessageBox::critical(this, "Error", "Communication with the board failed during the run");
+        break;
+    case Ex1Runner::NoSentinel:
+        ui->lblEx1RunStatus->setText("No sentinel configured");
+        QMessageBox::critical(this, "Error", "Run to completion needs a sentinel word: set [completion] sentinel in "
+                              + BoardMemoryMap::defaultFileName() + " or load an ELF program defining \"" TDT4255_SYMBOL_DONE "\"");
+        break;
+    }
+}
+
 void MainWindow::on_btnReadInst_clicked()
 {
-    QByteArray buf(256, 0);
-    m_board->readBuffer(TDT4255_EX1_INSMEM_BASEADDR, buf);
-    ui->instMemDisplay->setData(buf);
+    MemoryRegion r = memRegion(TDT4255_REGION_EX1_INSMEM);
+    QByteArray buf(r.size, 0);
+    if(m_board->readBuffer(r.baseAddress, buf))
+        showMemory(ui->instMemDisplay, buf);
 }
 
 void MainWindow::on_btnReadData_clicked()
 {
-    QByteArray buf(256, 0);
-    m_board->readBuffer(TDT4255_EX1_DATMEM_BASEADDR, buf);
-    ui->dataMemDisplay->setData(buf);
+    MemoryRegion r = memRegion(TDT4255_REGION_EX1_DATMEM);
+    QByteArray buf(r.size, 0);
+    if(m_board->readBuffer(r.baseAddress, buf))
+        showMemory(ui->dataMemDisplay, buf);
 }
 
 void MainWindow::on_btnWriteInst_clicked()
 {
-    m_board->writeBuffer(TDT4255_EX1_INSMEM_BASEADDR, ui->instMemDisplay->data());
+    MemoryRegion region = memRegion(TDT4255_REGION_EX1_INSMEM);
+    writeMemory(ui->instMemDisplay, region);
 }
 
 void MainWindow::on_btnWriteData_clicked()
 {
-    m_board->writeBuffer(TDT4255_EX1_DATMEM_BASEADDR, ui->dataMemDisplay->data());
+    MemoryRegion region = memRegion(TDT4255_REGION_EX1_DATMEM);
+    writeMemory(ui->dataMemDisplay, region);
 }
 
 void MainWindow::on_btnSaveDataToFile_clicked()
 {
-    QString fileName = QFileDialog::getSaveFileName(0, "Save Data Memory", "", "");
+    QString fileName = QFileDialog::getSaveFileName(0, "Save Data Memory", "", memoryFileFilter);
 
-    if(!fileName.isEmpty())
+    if(!fileName.isEmpty() && !saveMemoryFile(ui->dataMemDisplay, fileName, memRegion(TDT4255_REGION_EX1_DATMEM)))
+        QMessageBox::critical(this, "Error", "Could not write " + fileName);
+}
+
+void MainWindow::on_btnSaveInstToFile_clicked()
+{
+    QString fileName = QFileDialog::getSaveFileName(0, "Save Instruction Memory", "", memoryFileFilter);
+
+    if(!fileName.isEmpty() && !saveMemoryFile(ui->instMemDisplay, fileName, memRegion(TDT4255_REGION_EX1_INSMEM)))
+        QMessageBox::critical(this, "Error", "Could not write " + fileName);
+}
+
+void MainWindow::on_btnSampleStart_clicked()
+{
+    // addresses are separated by spaces or commas, hex needs the 0x prefix
+    QList<quint32> addresses;
+    foreach(QString elem, ui->txtSampleRegs->text().split(QRegExp("[\\s,]+"), QString::SkipEmptyParts))
     {
-        QFile f(fileName);
-        f.open(QIODevice::ReadWrite);
-        f.write(ui->dataMemDisplay->data());
-        f.close();
+        bool ok = false;
+        quint32 address = elem.toUInt(&ok, 0);
+        if(!ok)
+        {
+            QMessageBox::critical(this, "Error", "Invalid register address: " + elem);
+            return;
+        }
+        addresses.append(address);
     }
+
+    if(!m_sampler->setRegisters(addresses))
+    {
+        QMessageBox::critical(this, "Error", "Select between 1 and " + QString::number(TDT4255_SAMPLER_MAX_REGISTERS)
+                              + " registers to sample");
+        return;
+    }
+
+    m_sampler->setLinkShare(ui->spnLinkShare->value() / 100.0);
+    ui->plotSamples->clear();
+    m_sampler->start();
 }
 
-void MainWindow::on_btnSaveInstToFile_clicked()
+void MainWindow::on_btnSampleStop_clicked()
+{
+    m_sampler->stop();
+}
+
+void MainWindow::on_btnSampleExport_clicked()
 {
-    QString fileName = QFileDialog::getSaveFileName(0, "Save Instruction Memory", "", "");
+    QString fileName = QFileDialog::getSaveFileName(0, "Export Samples", "", "*.csv");
 
     if(!fileName.isEmpty())
     {
         QFile f(fileName);
-        f.open(QIODevice::ReadWrite);
-        f.write(ui->instMemDisplay->data());
+        if(!f.open(QIODevice::WriteOnly | QIODevice::Truncate) || !ui->plotSamples->exportCsv(&f))
+            QMessageBox::critical(this, "Error", "Could not export samples to " + fileName);
         f.close();
     }
 }
 
+void MainWindow::samplingStateChanged()
+{
+    bool running = m_sampler->isRunning();
+
+    ui->btnSampleStart->setEnabled(!running);
+    ui->btnSampleStop->setEnabled(running);
+    ui->txtSampleRegs->setEnabled(!running);
+    ui->spnLinkShare->setEnabled(!running);
+}
+
+void MainWindow::on_sldInstHistory_valueChanged(int value)
+{
+    showSnapshot(ui->instMemDisplay, m_instHistory, ui->sldInstHistory, value);
+}
+
+void MainWindow::on_sldDataHistory_valueChanged(int value)
+{
+    showSnapshot(ui->dataMemDisplay, m_dataHistory, ui->sldDataHistory, value);
+}
+
 void MainWindow::selInstAddrChanged(int addr)
 {
-    ui->lblSelInstAddr->setText("addr = " + QString::number(addr/4));
+    int wordWidth = memRegion(TDT4255_REGION_EX1_INSMEM).wordWidth;
+    ui->lblSelInstAddr->setText("addr = " + QString::number(addr/wordWidth));
 
-    QByteArray selWord = ui->instMemDisplay->data().mid(4*(addr/4),4);
-    int data = (*(int *) selWord.data());
+    quint64 selWord;
+    int size = readWord(ui->instMemDisplay, wordWidth*(addr/wordWidth), wordWidth, selWord);
 
-    ui->lblSelInstValSigned->setText("signed = " + QString::number((data)));
-    data = qToBigEndian(data);
-    ui->lblSelInstValHex->setText("hex =" + QByteArray((char *)&data, 4).toHex());
+    ui->lblSelInstValSigned->setText("signed = " + QString::number(wordToSigned(selWord, size)));
+    ui->lblSelInstValHex->setText("hex =" + wordToHex(selWord, size));
 }
 
 void MainWindow::selDataAddrChanged(int addr)
 {
-    ui->lblSelDataAddr->setText("addr = " + QString::number(addr/4));
-
-    QByteArray selWord = ui->dataMemDisplay->data().mid(4*(addr/4),4);
-    int data = (*(int *) selWord.data());
+    int wordWidth = memRegion(TDT4255_REGION_EX1_DATMEM).wordWidth;
+    ui->lblSelDataAddr->setText("addr = " + QString::number(addr/wordWidth));
 
-    ui->lblSelDataValSigned->setText("signed = " + QString::number((data)));
-    data = qToBigEndian(data);
-    ui->lblSelDataValHex->setText("hex =" + QByteArray((char *)&data, 4).toHex());
+    quint64 selWord;
+    int size = readWord(ui->dataMemDisplay, wordWidth*(addr/wordWidth), wordWidth, selWord);
 
+    ui->lblSelDataValSigned->setText("signed = " + QString::number(wordToSigned(selWord, size)));
+    ui->lblSelDataValHex->setText("hex =" + wordToHex(selWord, size));
 }
@@ -3,7 +3,16 @@
 
 #include <QMainWindow>
 #include <QList>
+#include <QMap>
 #include "tdt4255board.h"
+#include "registersampler.h"
+#include "ex1runner.h"
+#include "snapshothistory.h"
+#include "memoryimage.h"
+#include "elfimage.h"
+
+class QHexEdit;
+class QSlider;
 
 namespace Ui {
 class MainWindow;
@@ -23,10 +32,13 @@ public slots:
     void updateAllRegisters();
     void bufferOperationProgress(int current, int max);
     void bitfileOperationProgress(int current, int max);
+    void boardAttached();
+    void boardDetached();
 
 private slots:
     void on_btnConvertInstrs_clicked();
     void on_btnClrInstrs_clicked();
+    void on_chkFoldConstants_toggled(bool checked);
     void on_btnReadStackTop_clicked();
     void on_btnWriteProgram_clicked();
     void on_btnExecOne_clicked();
@@ -41,6 +53,7 @@ private slots:
     void on_btnEx1ProcReset_clicked();
     void on_btnEx1ProcStart_clicked();
     void on_btnEx1ProcStop_clicked();
+    void on_btnEx1RunToCompletion_clicked();
     void on_btnReadInst_clicked();
     void on_btnReadData_clicked();
     void on_btnWriteInst_clicked();
@@ -48,13 +61,56 @@ private slots:
     void on_btnSaveDataToFile_clicked();
     void on_btnSaveInstToFile_clicked();
 
+    void on_btnSampleStart_clicked();
+    void on_btnSampleStop_clicked();
+    void on_btnSampleExport_clicked();
+    void samplingStateChanged();
+
+    void on_sldInstHistory_valueChanged(int value);
+    void on_sldDataHistory_valueChanged(int value);
+
     void selInstAddrChanged(int addr);
     void selDataAddrChanged(int addr);
 
+    void findInMemory();
+    void findNextInMemory();
+
 private:
+    MemoryRegion memRegion(QString name);
+    void refreshRegisters(QList<BoardOperation> operations);
+    void showMemory(QHexEdit * view, const QByteArray & mem);
+    bool compileProgram(const QString & source);
+    void loadMemoryFile(QHexEdit * view, const QString & fileName, const MemoryRegion & region);
+    void writeMemory(QHexEdit * view, const MemoryRegion & region);
+    void loadMemoryImage(const QString & fileName, const MemoryRegion & region);
+    void loadElf(const QString & fileName);
+    // with clearUncovered, a memory the image has no bytes for is shown empty
+    int showImage(QHexEdit * view, const MemoryImage & image, const MemoryRegion & region, bool clearUncovered = false);
+    bool saveMemoryFile(QHexEdit * view, const QString & fileName, const MemoryRegion & region);
+    void showSnapshot(QHexEdit * view, SnapshotHistory & history, QSlider * slider, int index);
+    void restoreLiveView(QHexEdit * view);
+    QHexEdit * focusedMemoryView();
+
     Ui::MainWindow *ui;
     TDT4255Board * m_board;
+    RegisterSampler * m_sampler;
+    Ex1Runner * m_ex1Runner;
+    SnapshotHistory m_instHistory;
+    SnapshotHistory m_dataHistory;
     QList<quint16> m_programData;
+    QString m_programSource;            // RPN source of the Ex0 program
+    QString m_searchPattern;
+    QList<QHexEdit *> m_imageViews;     // views showing a sparse memory image
+
+    // live contents of a view while it shows a past snapshot
+    struct LiveView
+    {
+        QByteArray data;
+        bool isImage;
+        QList<DiffRange> changed;
+    };
+    QMap<QHexEdit *, LiveView> m_liveViews;
+    ElfImage m_program;                 // last loaded ELF program, for its symbols
 
 };
 
@@ -0,0 +1,154 @@
+#include <string.h>
+#include "memorydiff.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+static inline int countTrailingZeros(quint64 v)
+{
+#if defined(__GNUC__)
+    return __builtin_ctzll(v);
+#else
+    int n = 0;
+    while(!(v & 1))
+    {
+        v >>= 1;
+        n++;
+    }
+    return n;
+#endif
+}
+
+static inline quint64 loadWord(const char * p)
+{
+    quint64 w;
+    memcpy(&w, p, sizeof(w));
+    return w;
+}
+
+// index of the first zero byte of v, in memory order
+static inline int firstZeroByte(quint64 v)
+{
+    for(int i = 0; i < 8; i++)
+    {
+        if(((const unsigned char *) &v)[i] == 0)
+            return i;
+    }
+    return 8;
+}
+
+QList<DiffRange> MemoryDiff::compare(const QByteArray &a, const QByteArray &b, int mergeGap)
+{
+    int common = qMin(a.size(), b.size());
+    QList<DiffRange> ranges = compare(a.constData(), b.constData(), common, mergeGap);
+
+    // the tail of the longer snapshot has nothing to compare against
+    int longer = qMax(a.size(), b.size());
+    if(longer > common)
+    {
+        if(!ranges.isEmpty() && common - ranges.last().end() <= mergeGap)
+            ranges.last().length = longer - ranges.last().offset;
+        else
+            ranges.append(DiffRange(common, longer - common));
+    }
+
+    return ranges;
+}
+
+QList<DiffRange> MemoryDiff::compare(const char *a, const char *b, int length, int mergeGap)
+{
+    QList<DiffRange> ranges;
+
+    int pos = findDifference(a, b, 0, length);
+    while(pos < length)
+    {
+        int end = findEqual(a, b, pos, length);
+
+        if(!ranges.isEmpty() && pos - ranges.last().end() <= mergeGap)
+            ranges.last().length = end - ranges.last().offset;
+        else
+            ranges.append(DiffRange(pos, end - pos));
+
+        pos = findDifference(a, b, end, length);
+    }
+
+    return ranges;
+}
+
+int MemoryDiff::differingBytes(const QList<DiffRange> &ranges)
+{
+    int total = 0;
+    foreach(DiffRange r, ranges)
+        total += r.length;
+    return total;
+}
+
+int MemoryDiff::findDifference(const char *a, const char *b, int from, int length)
+{
+    int i = from;
+
+#ifdef __SSE2__
+    for(; i + 16 <= length; i += 16)
+    {
+        __m128i va = _mm_loadu_si128((const __m128i *) (a + i));
+        __m128i vb = _mm_loadu_si128((const __m128i *) (b + i));
+        int equalMask = _mm_movemask_epi8(_mm_cmpeq_epi8(va, vb));
+        if(equalMask != 0xFFFF)
+            return i + countTrailingZeros(~equalMask & 0xFFFF);
+    }
+#endif
+
+    for(; i + 8 <= length; i += 8)
+    {
+        quint64 x = loadWord(a + i) ^ loadWord(b + i);
+        if(x != 0)
+        {
+            // the lowest differing byte in memory order
+            for(int j = 0; j < 8; j++)
+            {
+                if(a[i + j] != b[i + j])
+                    return i + j;
+            }
+        }
+    }
+
+    for(; i < length; i++)
+    {
+        if(a[i] != b[i])
+            return i;
+    }
+
+    return length;
+}
+
+int MemoryDiff::findEqual(const char *a, const char *b, int from, int length)
+{
+    int i = from;
+
+#ifdef __SSE2__
+    for(; i + 16 <= length; i += 16)
+    {
+        __m128i va = _mm_loadu_si128((const __m128i *) (a + i));
+        __m128i vb = _mm_loadu_si128((const __m128i *) (b + i));
+        int equalMask = _mm_movemask_epi8(_mm_cmpeq_epi8(va, vb));
+        if(equalMask != 0)
+            return i + countTrailingZeros(equalMask);
+    }
+#endif
+
+    for(; i + 8 <= length; i += 8)
+    {
+        int j = firstZeroByte(loadWord(a + i) ^ loadWord(b + i));
+        if(j < 8)
+            return i + j;
+    }
+
+    for(; i < length; i++)
+    {
+        if(a[i] == b[i])
+            return i;
+    }
+
+    return length;
+}
@@ -0,0 +1,38 @@
+#ifndef MEMORYDIFF_H
+#define MEMORYDIFF_H
+
+#include <QByteArray>
+#include <QList>
+
+// half-open range [offset, offset + length) of differing bytes
+struct DiffRange
+{
+    DiffRange(int offset = 0, int length = 0) : offset(offset), length(length) {}
+
+    int end() const { return offset + length; }
+
+    int offset;
+    int length;
+};
+
+// Compares memory snapshots and reports the differing bytes as coalesced
+// ranges. Matching stretches are skipped 16 bytes at a time with SSE2
+// compares where available, or a machine word at a time otherwise, so
+// large mostly-equal dumps are compared at memory bandwidth.
+class MemoryDiff
+{
+public:
+    // ranges separated by at most mergeGap equal bytes are merged into
+    // one; bytes beyond the end of the shorter snapshot count as differing
+    static QList<DiffRange> compare(const QByteArray & a, const QByteArray & b, int mergeGap = 0);
+    static QList<DiffRange> compare(const char * a, const char * b, int length, int mergeGap = 0);
+
+    static int differingBytes(const QList<DiffRange> & ranges);
+
+    // index of the first byte in [from, length) where a and b differ
+    // (or are equal, for findEqual), or length if there is none
+    static int findDifference(const char * a, const char * b, int from, int length);
+    static int findEqual(const char * a, const char * b, int from, int length);
+};
+
+#endif // MEMORYDIFF_H
@@ -0,0 +1,501 @@
+#include <string.h>
+#include <QFile>
+#include <QFileInfo>
+#include <QDebug>
+#include "memoryimage.h"
+
+const int MAX_LINE_LENGTH = 1024;       // longest records have 255 data bytes
+const int RECORD_DATA_BYTES = 16;       // data bytes per written record
+const int RAW_CHUNK_SIZE = 64 * 1024;
+
+static int hexValue(char c)
+{
+    if(c >= '0' && c <= '9')
+        return c - '0';
+    if(c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    if(c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    return -1;
+}
+
+// decodes the hex digit pairs of a record, returns the number of bytes or
+// -1 if the digits are malformed
+static int decodeRecord(const char * digits, int length, quint8 * bytes)
+{
+    if(length % 2 != 0)
+        return -1;
+
+    for(int i = 0; i < length / 2; i++)
+    {
+        int hi = hexValue(digits[2 * i]);
+        int lo = hexValue(digits[2 * i + 1]);
+        if(hi < 0 || lo < 0)
+            return -1;
+        bytes[i] = (quint8) ((hi << 4) | lo);
+    }
+    return length / 2;
+}
+
+// reads the next line without its line break into line, returns its length,
+// 0 for an empty line, -1 at the end and -2 if the line is too long
+static int readRecordLine(QIODevice * device, char * line)
+{
+    qint64 n = device->readLine(line, MAX_LINE_LENGTH);
+    if(n <= 0)
+        return -1;
+    if(n == MAX_LINE_LENGTH - 1 && line[n - 1] != '\n')
+        return -2;
+
+    while(n > 0 && (line[n - 1] == '\n' || line[n - 1] == '\r' || line[n - 1] == ' ' || line[n - 1] == '\t'))
+        n--;
+    return (int) n;
+}
+
+static QByteArray encodeRecord(const char * prefix, const quint8 * bytes, int count)
+{
+    static const char digits[] = "0123456789ABCDEF";
+
+    QByteArray line(prefix);
+    line.reserve(line.size() + 2 * count + 1);
+    for(int i = 0; i < count; i++)
+    {
+        line.append(digits[bytes[i] >> 4]);
+        line.append(digits[bytes[i] & 0x0f]);
+    }
+    line.append('\n');
+    return line;
+}
+
+MemoryImage::MemoryImage()
+{
+}
+
+MemoryImage::Format MemoryImage::formatForFile(const QString &fileName)
+{
+    QString suffix = QFileInfo(fileName).suffix().toLower();
+
+    if(suffix == "hex" || suffix == "ihx" || suffix == "ihex")
+        return IntelHex;
+    if(suffix == "srec" || suffix == "s19" || suffix == "s28" || suffix == "s37" || suffix == "mot")
+        return SRecord;
+    return Raw;
+}
+
+bool MemoryImage::load(const QString &fileName, quint32 rawAddress)
+{
+    QFile f(fileName);
+    if(!f.open(QIODevice::ReadOnly))
+        return fail("could not open " + fileName);
+
+    return load(&f, formatForFile(fileName), rawAddress);
+}
+
+bool MemoryImage::load(QIODevice *device, Format format, quint32 rawAddress)
+{
+    clear();
+    m_errorString.clear();
+
+    bool ok;
+    switch(format)
+    {
+    case IntelHex:  ok = loadIntelHex(device); break;
+    case SRecord:   ok = loadSRecord(device); break;
+    default:        ok = loadRaw(device, rawAddress); break;
+    }
+
+    // a broken file leaves no partial image behind
+    if(!ok)
+        clear();
+    return ok;
+}
+
+bool MemoryImage::save(const QString &fileName, Format format) const
+{
+    QFile f(fileName);
+    if(!f.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return fail("could not open " + fileName + " for writing");
+
+    return save(&f, format) && f.flush();
+}
+
+bool MemoryImage::save(QIODevice *device, Format format) const
+{
+    switch(format)
+    {
+    case IntelHex:  return saveIntelHex(device);
+    case SRecord:   return saveSRecord(device);
+    default:        return saveRaw(device);
+    }
+}
+
+QString MemoryImage::errorString() const
+{
+    return m_errorString;
+}
+
+void MemoryImage::clear()
+{
+    m_segments.clear();
+}
+
+bool MemoryImage::isEmpty() const
+{
+    return m_segments.isEmpty();
+}
+
+void MemoryImage::addData(quint32 address, const QByteArray &data)
+{
+    // bytes beyond the 32 bit address space are dropped
+    QByteArray bytes = data.left((int) qMin<quint64>(data.size(), Q_UINT64_C(0x100000000) - address));
+    if(bytes.isEmpty())
+        return;
+    quint64 end = (quint64) address + bytes.size();
+
+    // usually the data continues the segment in front of it, and can be
+    // appended unless it reaches the next segment
+    QMap<quint32, QByteArray>::iterator next = m_segments.upperBound(address);
+    QMap<quint32, QByteArray>::iterator first = next;
+    if(next != m_segments.begin())
+    {
+        QMap<quint32, QByteArray>::iterator prev = next;
+        --prev;
+        quint64 prevEnd = (quint64) prev.key() + prev.value().size();
+        if(prevEnd == address && (next == m_segments.end() || next.key() > end))
+        {
+            prev.value().append(bytes);
+            return;
+        }
+        if(prevEnd >= address)
+            first = prev;
+    }
+
+    // otherwise all segments overlapping or touching the data are merged
+    quint32 start = address;
+    quint64 stop = end;
+    QMap<quint32, QByteArray>::iterator it = first;
+    for(; it != m_segments.end() && it.key() <= end; ++it)
+    {
+        start = qMin(start, it.key());
+        stop = qMax(stop, (quint64) it.key() + it.value().size());
+    }
+
+    QByteArray merged((int) (stop - start), 0);
+    for(it = first; it != m_segments.end() && it.key() <= end; )
+    {
+        memcpy(merged.data() + (it.key() - start), it.value().constData(), it.value().size());
+        it = m_segments.erase(it);
+    }
+    memcpy(merged.data() + (address - start), bytes.constData(), bytes.size());
+
+    m_segments.insert(start, merged);
+}
+
+void MemoryImage::relocate(qint64 offset)
+{
+    QMap<quint32, QByteArray> segments = m_segments;
+    m_segments.clear();
+
+    QMap<quint32, QByteArray>::const_iterator it;
+    for(it = segments.constBegin(); it != segments.constEnd(); ++it)
+    {
+        qint64 address = (qint64) it.key() + offset;
+        if(address >= 0 && address <= Q_INT64_C(0xFFFFFFFF))
+            addData((quint32) address, it.value());
+    }
+}
+
+QList<ImageSegment> MemoryImage::segments() const
+{
+    QList<ImageSegment> result;
+
+    QMap<quint32, QByteArray>::const_iterator it;
+    for(it = m_segments.constBegin(); it != m_segments.constEnd(); ++it)
+        result.append(ImageSegment(it.key(), it.value()));
+
+    return result;
+}
+
+QList<ImageSegment> MemoryImage::segmentsIn(const MemoryRegion &region) const
+{
+    QList<ImageSegment> result;
+    quint64 regionEnd = (quint64) region.baseAddress + region.size;
+
+    // the segment in front of the region may reach into it
+    QMap<quint32, QByteArray>::const_iterator it = m_segments.upperBound(region.baseAddress);
+    if(it != m_segments.constBegin())
+        --it;
+
+    for(; it != m_segments.constEnd() && it.key() < regionEnd; ++it)
+    {
+        quint64 from = qMax<quint64>(it.key(), region.baseAddress);
+        quint64 to = qMin<quint64>((quint64) it.key() + it.value().size(), regionEnd);
+        if(from < to)
+            result.append(ImageSegment((quint32) from, it.value().mid((int) (from - it.key()), (int) (to - from))));
+    }
+
+    return result;
+}
+
+int MemoryImage::byteCount() const
+{
+    int total = 0;
+    foreach(const QByteArray & data, m_segments)
+        total += data.size();
+    return total;
+}
+
+bool MemoryImage::loadRaw(QIODevice *device, quint32 address)
+{
+    quint64 pos = address;
+    while(!device->atEnd())
+    {
+        QByteArray chunk = device->read(RAW_CHUNK_SIZE);
+        if(chunk.isEmpty())
+            break;
+        addData((quint32) pos, chunk);
+        pos += chunk.size();
+    }
+    return true;
+}
+
+bool MemoryImage::loadIntelHex(QIODevice *device)
+{
+    char line[MAX_LINE_LENGTH];
+    quint8 record[MAX_LINE_LENGTH / 2];
+    quint32 base = 0;       // from extended segment or linear address records
+
+    for(int lineNo = 1; ; lineNo++)
+    {
+        int len = readRecordLine(device, line);
+        if(len == -1)
+            return true;        // a missing end-of-file record is tolerated
+        if(len == -2)
+            return fail(QString("line %1 is too long").arg(lineNo));
+        if(len == 0)
+            continue;
+
+        int n = (line[0] == ':') ? decodeRecord(line + 1, len - 1, record) : -1;
+        if(n < 5 || n != 5 + record[0])
+            return fail(QString("malformed record in line %1").arg(lineNo));
+
+        quint8 sum = 0;
+        for(int i = 0; i < n; i++)
+            sum += record[i];
+        if(sum != 0)
+            return fail(QString("checksum error in line %1").arg(lineNo));
+
+        int count = record[0];
+        quint32 offset = (record[1] << 8) | record[2];
+        const quint8 * data = record + 4;
+
+        switch(record[3])
+        {
+        case 0x00:
+            addData(base + offset, QByteArray((const char *) data, count));
+            break;
+        case 0x01:
+            return true;
+        case 0x02:
+        case 0x04:
+            if(count != 2)
+                return fail(QString("malformed address record in line %1").arg(lineNo));
+            base = (data[0] << 8) | data[1];
+            base <<= (record[3] == 0x02) ? 4 : 16;
+            break;
+        case 0x03:
+        case 0x05:
+            // start addresses do not matter for the board
+            break;
+        default:
+            return fail(QString("unknown record type %1 in line %2").arg(record[3]).arg(lineNo));
+        }
+    }
+}
+
+bool MemoryImage::loadSRecord(QIODevice *device)
+{
+    char line[MAX_LINE_LENGTH];
+    quint8 record[MAX_LINE_LENGTH / 2];
+
+    for(int lineNo = 1; ; lineNo++)
+    {
+        int len = readRecordLine(device, line);
+        if(len == -1)
+            return true;        // a missing termination record is tolerated
+        if(len == -2)
+            return fail(QString("line %1 is too long").arg(lineNo));
+        if(len == 0)
+            continue;
+
+        int type = (len >= 2 && line[0] == 'S') ? hexValue(line[1]) : -1;
+        int n = (type >= 0 && type <= 9) ? decodeRecord(line + 2, len - 2, record) : -1;
+        if(n < 1 || n != 1 + record[0])
+            return fail(QString("malformed record in line %1").arg(lineNo));
+
+        // the checksum is the ones' complement of the sum of the other bytes
+        quint8 sum = 0;
+        for(int i = 0; i < n; i++)
+            sum += record[i];
+        if(sum != 0xFF)
+            return fail(QString("checksum error in line %1").arg(lineNo));
+
+        // S1/S9 have 16 bit, S2/S8 24 bit and S3/S7 32 bit addresses
+        int addressBytes;
+        switch(type)
+        {
+        case 0: case 1: case 5: case 9: addressBytes = 2; break;
+        case 2: case 6: case 8:         addressBytes = 3; break;
+        case 3: case 7:                 addressBytes = 4; break;
+        default:
+            return fail(QString("unknown record type S%1 in line %2").arg(type).arg(lineNo));
+        }
+
+        int count = record[0] - addressBytes - 1;
+        if(count < 0)
+            return fail(QString("malformed record in line %1").arg(lineNo));
+
+        quint32 address = 0;
+        for(int i = 0; i < addressBytes; i++)
+            address = (address << 8) | record[1 + i];
+
+        if(type >= 1 && type <= 3)
+            addData(address, QByteArray((const char *) record + 1 + addressBytes, count));
+        else if(type >= 7)
+            return true;
+        // S0 headers and S5/S6 record counts carry no data
+    }
+}
+
+bool MemoryImage::saveRaw(QIODevice *device) const
+{
+    // holes between the segments are written as zeros
+    QByteArray zeros(RAW_CHUNK_SIZE, 0);
+    quint64 pos = m_segments.isEmpty() ? 0 : m_segments.constBegin().key();
+
+    QMap<quint32, QByteArray>::const_iterator it;
+    for(it = m_segments.constBegin(); it != m_segments.constEnd(); ++it)
+    {
+        while(pos < it.key())
+        {
+            qint64 len = qMin<quint64>(zeros.size(), it.key() - pos);
+            if(device->write(zeros.constData(), len) != len)
+                return fail("write error");
+            pos += len;
+        }
+        if(device->write(it.value()) != it.value().size())
+            return fail("write error");
+        pos += it.value().size();
+    }
+    return true;
+}
+
+bool MemoryImage::saveIntelHex(QIODevice *device) const
+{
+    quint8 record[5 + RECORD_DATA_BYTES];
+    quint32 upper = 0;      // upper address bits of the last extended linear address record
+
+    QMap<quint32, QByteArray>::const_iterator it;
+    for(it = m_segments.constBegin(); it != m_segments.constEnd(); ++it)
+    {
+        const QByteArray & data = it.value();
+        int pos = 0;
+        while(pos < data.size())
+        {
+            quint32 address = it.key() + pos;
+            if((address >> 16) != upper)
+            {
+                upper = address >> 16;
+                quint8 ela[] = { 0x02, 0x00, 0x00, 0x04, (quint8) (upper >> 8), (quint8) upper, 0 };
+                for(int i = 0; i < 6; i++)
+                    ela[6] -= ela[i];
+                if(device->write(encodeRecord(":", ela, 7)) < 0)
+                    return fail("write error");
+            }
+
+            // records do not cross a 64K boundary
+            int count = qMin(qMin(RECORD_DATA_BYTES, data.size() - pos), (int) (0x10000 - (address & 0xFFFF)));
+            record[0] = (quint8) count;
+            record[1] = (quint8) (address >> 8);
+            record[2] = (quint8) address;
+            record[3] = 0x00;
+            memcpy(record + 4, data.constData() + pos, count);
+
+            quint8 sum = 0;
+            for(int i = 0; i < 4 + count; i++)
+                sum += record[i];
+            record[4 + count] = (quint8) -sum;
+
+            if(device->write(encodeRecord(":", record, 5 + count)) < 0)
+                return fail("write error");
+            pos += count;
+        }
+    }
+
+    if(device->write(":00000001FF\n") < 0)
+        return fail("write error");
+    return true;
+}
+
+bool MemoryImage::saveSRecord(QIODevice *device) const
+{
+    // the narrowest address field that fits all segments
+    quint64 end = m_segments.isEmpty() ? 0 : (quint64) m_segments.lastKey() + m_segments.last().size();
+    int addressBytes = (end <= 0x10000) ? 2 : (end <= 0x1000000) ? 3 : 4;
+    const char * dataType = (addressBytes == 2) ? "S1" : (addressBytes == 3) ? "S2" : "S3";
+    const char * endType = (addressBytes == 2) ? "S9" : (addressBytes == 3) ? "S8" : "S7";
+
+    quint8 record[1 + 4 + RECORD_DATA_BYTES + 1];
+    int records = 0;
+
+    if(device->write("S0030000FC\n") < 0)
+        return fail("write error");
+
+    QMap<quint32, QByteArray>::const_iterator it;
+    for(it = m_segments.constBegin(); it != m_segments.constEnd(); ++it)
+    {
+        const QByteArray & data = it.value();
+        for(int pos = 0; pos < data.size(); pos += RECORD_DATA_BYTES)
+        {
+            int count = qMin(RECORD_DATA_BYTES, data.size() - pos);
+            quint32 address = it.key() + pos;
+
+            record[0] = (quint8) (addressBytes + count + 1);
+            for(int i = 0; i < addressBytes; i++)
+                record[1 + i] = (quint8) (address >> (8 * (addressBytes - 1 - i)));
+            memcpy(record + 1 + addressBytes, data.constData() + pos, count);
+
+            quint8 sum = 0;
+            for(int i = 0; i < 1 + addressBytes + count; i++)
+                sum += record[i];
+            record[1 + addressBytes + count] = (quint8) ~sum;
+
+            if(device->write(encodeRecord(dataType, record, 2 + addressBytes + count)) < 0)
+                return fail("write error");
+            records++;
+        }
+    }
+
+    // record count (if it fits) and termination record
+    if(records <= 0xFFFF)
+    {
+        quint8 count[] = { 0x03, (quint8) (records >> 8), (quint8) records, 0 };
+        count[3] = (quint8) ~(count[0] + count[1] + count[2]);
+        if(device->write(encodeRecord("S5", count, 4)) < 0)
+            return fail("write error");
+    }
+
+    quint8 term[6] = { (quint8) (addressBytes + 1), 0, 0, 0, 0, 0 };
+    term[1 + addressBytes] = (quint8) ~term[0];
+    if(device->write(encodeRecord(endType, term, 2 + addressBytes)) < 0)
+        return fail("write error");
+
+    return true;
+}
+
+bool MemoryImage::fail(QString message) const
+{
+    qDebug() << "memory image:" << message;
+    m_errorString = message;
+    return false;
+}
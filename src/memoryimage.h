@@ -0,0 +1,76 @@
+#ifndef MEMORYIMAGE_H
+#define MEMORYIMAGE_H
+
+#include <QByteArray>
+#include <QIODevice>
+#include <QList>
+#include <QMap>
+#include <QString>
+#include "boardmemorymap.h"
+
+// contiguous run of bytes of a memory image
+struct ImageSegment
+{
+    ImageSegment(quint32 address = 0, QByteArray data = QByteArray()) : address(address), data(data) {}
+
+    quint64 end() const { return (quint64) address + data.size(); }
+
+    quint32 address;
+    QByteArray data;
+};
+
+/*
+ MemoryImage is a sparse memory image: a set of segments at absolute
+ addresses, with holes in between. It reads and writes raw binaries, Intel
+ HEX (record types 00-05) and Motorola S-records (S0-S9), verifying the
+ checksum of every record.
+
+ Files are parsed a line at a time; records are appended to the segment
+ they continue, so only the bytes present in the file are held, never a
+ buffer spanning the whole address range. An image may cover several board
+ regions, segmentsIn() clips it to one of them.
+*/
+class MemoryImage
+{
+public:
+    enum Format { Raw, IntelHex, SRecord };
+
+    MemoryImage();
+
+    // the format is taken from the extension (.hex/.ihx, .srec/.s19/.s28/.s37/.mot),
+    // other files are raw
+    static Format formatForFile(const QString & fileName);
+
+    // raw files are placed at rawAddress
+    bool load(const QString & fileName, quint32 rawAddress = 0);
+    bool load(QIODevice * device, Format format, quint32 rawAddress = 0);
+    bool save(const QString & fileName, Format format) const;
+    bool save(QIODevice * device, Format format) const;
+    QString errorString() const;
+
+    void clear();
+    bool isEmpty() const;
+    // later data replaces earlier data at the same addresses
+    void addData(quint32 address, const QByteArray & data);
+    void relocate(qint64 offset);
+
+    // segments in ascending order of address, adjacent ones are merged
+    QList<ImageSegment> segments() const;
+    // the parts of the segments inside region
+    QList<ImageSegment> segmentsIn(const MemoryRegion & region) const;
+    int byteCount() const;
+
+private:
+    bool loadRaw(QIODevice * device, quint32 address);
+    bool loadIntelHex(QIODevice * device);
+    bool loadSRecord(QIODevice * device);
+    bool saveRaw(QIODevice * device) const;
+    bool saveIntelHex(QIODevice * device) const;
+    bool saveSRecord(QIODevice * device) const;
+    bool fail(QString message) const;
+
+    QMap<quint32, QByteArray> m_segments;   // by start address
+    mutable QString m_errorString;
+};
+
+#endif // MEMORYIMAGE_H
@@ -0,0 +1,163 @@
+#include "mipsdisasm.h"
+
+static const char * const registerNames[32] = {
+    "zero", "at", "v0", "v1", "a0", "a1", "a2", "a3",
+    "t0", "t1", "t2", "t3", "t4", "t5", "t6", "t7",
+    "s0", "s1", "s2", "s3", "s4", "s5", "s6", "s7",
+    "t8", "t9", "k0", "k1", "gp", "sp", "fp", "ra"
+};
+
+// mnemonics of the SPECIAL (opcode 0) instructions by function field
+static const char * specialName(int funct)
+{
+    switch(funct)
+    {
+    case 0x00: return "sll";
+    case 0x02: return "srl";
+    case 0x03: return "sra";
+    case 0x04: return "sllv";
+    case 0x06: return "srlv";
+    case 0x07: return "srav";
+    case 0x08: return "jr";
+    case 0x09: return "jalr";
+    case 0x0c: return "syscall";
+    case 0x0d: return "break";
+    case 0x10: return "mfhi";
+    case 0x11: return "mthi";
+    case 0x12: return "mflo";
+    case 0x13: return "mtlo";
+    case 0x18: return "mult";
+    case 0x19: return "multu";
+    case 0x1a: return "div";
+    case 0x1b: return "divu";
+    case 0x20: return "add";
+    case 0x21: return "addu";
+    case 0x22: return "sub";
+    case 0x23: return "subu";
+    case 0x24: return "and";
+    case 0x25: return "or";
+    case 0x26: return "xor";
+    case 0x27: return "nor";
+    case 0x2a: return "slt";
+    case 0x2b: return "sltu";
+    default:   return 0;
+    }
+}
+
+static QString hex(quint32 value)
+{
+    return "0x" + QString::number(value, 16);
+}
+
+QString MipsDisassembler::registerName(int reg)
+{
+    return QString("$") + registerNames[reg & 0x1f];
+}
+
+QString MipsDisassembler::disassemble(quint32 word, quint32 address)
+{
+    int opcode = word >> 26;
+    int rs = (word >> 21) & 0x1f;
+    int rt = (word >> 16) & 0x1f;
+    int rd = (word >> 11) & 0x1f;
+    int shamt = (word >> 6) & 0x1f;
+    int funct = word & 0x3f;
+    qint16 imm = (qint16) (word & 0xffff);
+    quint32 uimm = word & 0xffff;
+    quint32 branchTarget = address + 4 + ((qint32) imm << 2);
+
+    QString s = registerName(rs);
+    QString t = registerName(rt);
+    QString d = registerName(rd);
+
+    if(word == 0)
+        return "nop";
+
+    switch(opcode)
+    {
+    case 0x00:
+    {
+        const char * name = specialName(funct);
+        if(!name)
+            break;
+
+        switch(funct)
+        {
+        case 0x00: case 0x02: case 0x03:
+            return QString("%1 %2, %3, %4").arg(name).arg(d).arg(t).arg(shamt);
+        case 0x04: case 0x06: case 0x07:
+            return QString("%1 %2, %3, %4").arg(name).arg(d).arg(t).arg(s);
+        case 0x08: case 0x11: case 0x13:
+            return QString("%1 %2").arg(name).arg(s);
+        case 0x09:
+            return (rd == 31) ? QString("jalr %1").arg(s) : QString("jalr %1, %2").arg(d).arg(s);
+        case 0x0c: case 0x0d:
+            return name;
+        case 0x10: case 0x12:
+            return QString("%1 %2").arg(name).arg(d);
+        case 0x18: case 0x19: case 0x1a: case 0x1b:
+            return QString("%1 %2, %3").arg(name).arg(s).arg(t);
+        default:
+            return QString("%1 %2, %3, %4").arg(name).arg(d).arg(s).arg(t);
+        }
+    }
+    case 0x01:
+    {
+        // REGIMM, the rt field selects the branch condition
+        const char * name = 0;
+        switch(rt)
+        {
+        case 0x00: name = "bltz"; break;
+        case 0x01: name = "bgez"; break;
+        case 0x10: name = "bltzal"; break;
+        case 0x11: name = "bgezal"; break;
+        }
+        if(!name)
+            break;
+        return QString("%1 %2, %3").arg(name).arg(s).arg(hex(branchTarget));
+    }
+    case 0x02:
+    case 0x03:
+    {
+        quint32 target = ((address + 4) & 0xf0000000) | ((word & 0x03ffffff) << 2);
+        return QString("%1 %2").arg(opcode == 0x02 ? "j" : "jal").arg(hex(target));
+    }
+    case 0x04:
+        if(rs == 0 && rt == 0)
+            return QString("b %1").arg(hex(branchTarget));
+        return QString("beq %1, %2, %3").arg(s).arg(t).arg(hex(branchTarget));
+    case 0x05:
+        return QString("bne %1, %2, %3").arg(s).arg(t).arg(hex(branchTarget));
+    case 0x06:
+        return QString("blez %1, %2").arg(s).arg(hex(branchTarget));
+    case 0x07:
+        return QString("bgtz %1, %2").arg(s).arg(hex(branchTarget));
+    case 0x08:
+        return QString("addi %1, %2, %3").arg(t).arg(s).arg(imm);
+    case 0x09:
+        return QString("addiu %1, %2, %3").arg(t).arg(s).arg(imm);
+    case 0x0a:
+        return QString("slti %1, %2, %3").arg(t).arg(s).arg(imm);
+    case 0x0b:
+        return QString("sltiu %1, %2, %3").arg(t).arg(s).arg(imm);
+    case 0x0c:
+        return QString("andi %1, %2, %3").arg(t).arg(s).arg(hex(uimm));
+    case 0x0d:
+        return QString("ori %1, %2, %3").arg(t).arg(s).arg(hex(uimm));
+    case 0x0e:
+        return QString("xori %1, %2, %3").arg(t).arg(s).arg(hex(uimm));
+    case 0x0f:
+        return QString("lui %1, %2").arg(t).arg(hex(uimm));
+    case 0x20: case 0x21: case 0x23: case 0x24: case 0x25:
+    case 0x28: case 0x29: case 0x2b:
+    {
+        static const char * const memNames[] = {
+            "lb", "lh", 0, "lw", "lbu", "lhu", 0, 0,
+            "sb", "sh", 0, "sw"
+        };
+        return QString("%1 %2, %3(%4)").arg(memNames[opcode - 0x20]).arg(t).arg(imm).arg(s);
+    }
+    }
+
+    return ".word " + QString("0x%1").arg(word, 8, 16, QChar('0'));
+}
@@ -0,0 +1,22 @@
+#ifndef MIPSDISASM_H
+#define MIPSDISASM_H
+
+#include <QString>
+
+// Disassembles single MIPS32 instruction words into assembler syntax, e.g.
+// "addiu $sp, $sp, -32". Covers the integer subset implemented by the ex1
+// processors (arithmetic, logic, shifts, loads and stores, branches and
+// jumps); other words are shown as ".word 0x...". Branch and jump targets
+// are resolved against the address of the instruction.
+class MipsDisassembler
+{
+public:
+    // no disassembly is longer, e.g "bne $zero, $zero, 0xfffffffc"
+    static const int MAX_LENGTH = 28;
+
+    static QString disassemble(quint32 word, quint32 address = 0);
+
+    static QString registerName(int reg);
+};
+
+#endif // MIPSDISASM_H
@@ -0,0 +1,143 @@
+#include <QDebug>
+#include "registersampler.h"
+
+// how long to wait for a locked link to become free, in milliseconds
+const int LOCKED_RETRY_INTERVAL = 10;
+
+RegisterSampler::RegisterSampler(TDT4255Board *board, QObject *parent) :
+    QObject(parent)
+{
+    m_board = board;
+    m_linkShare = 0.5;
+    m_sampleRate = 0;
+    m_lastSampleStart = -1;
+    m_droppedSamples = 0;
+
+    m_timer.setSingleShot(true);
+    connect(&m_timer, SIGNAL(timeout()), this, SLOT(takeSample()));
+}
+
+bool RegisterSampler::setRegisters(QList<quint32> addresses)
+{
+    if(addresses.isEmpty() || addresses.size() > TDT4255_SAMPLER_MAX_REGISTERS)
+    {
+        qDebug() << "RegisterSampler: between 1 and" << TDT4255_SAMPLER_MAX_REGISTERS << "registers can be sampled";
+        return false;
+    }
+
+    m_registers = addresses;
+    return true;
+}
+
+QList<quint32> RegisterSampler::registers()
+{
+    return m_registers;
+}
+
+void RegisterSampler::setLinkShare(double share)
+{
+    m_linkShare = qBound(0.01, share, 1.0);
+}
+
+double RegisterSampler::linkShare()
+{
+    return m_linkShare;
+}
+
+bool RegisterSampler::isRunning()
+{
+    return m_clock.isValid();
+}
+
+double RegisterSampler::sampleRate()
+{
+    return m_sampleRate;
+}
+
+int RegisterSampler::droppedSamples()
+{
+    return m_droppedSamples;
+}
+
+RegisterSampleBuffer & RegisterSampler::samples()
+{
+    return m_samples;
+}
+
+void RegisterSampler::start()
+{
+    if(isRunning() || m_registers.isEmpty())
+        return;
+
+    m_samples.clear();
+    m_sampleRate = 0;
+    m_lastSampleStart = -1;
+    m_droppedSamples = 0;
+    m_clock.start();
+    m_timer.start(0);
+
+    emit started();
+}
+
+void RegisterSampler::stop()
+{
+    if(!isRunning())
+        return;
+
+    m_timer.stop();
+    m_clock.invalidate();
+
+    emit stopped();
+}
+
+void RegisterSampler::takeSample()
+{
+    if(!isRunning())
+        return;
+
+    // someone else owns the link, try again later
+    if(m_board->isLinkLocked())
+    {
+        m_timer.start(LOCKED_RETRY_INTERVAL);
+        return;
+    }
+
+    QList<BoardOperation> ops;
+    foreach(quint32 address, m_registers)
+        ops << BoardOperation::read(address, 1);
+
+    qint64 begin = m_clock.nsecsElapsed() / 1000;
+    bool ok = m_board->executeTransaction(ops, false, true);
+    qint64 end = m_clock.nsecsElapsed() / 1000;
+
+    if(!ok)
+    {
+        qDebug() << "RegisterSampler: sampling failed, stopping";
+        stop();
+        emit samplingError();
+        return;
+    }
+
+    // the registers were read somewhere within the transaction
+    RegisterSample sample;
+    sample.timestamp = (begin + end) / 2;
+    for(int i = 0; i < TDT4255_SAMPLER_MAX_REGISTERS; i++)
+        sample.values[i] = (i < ops.size()) ? (quint8) ops.at(i).data.at(0) : 0;
+
+    if(!m_samples.push(sample))
+        m_droppedSamples++;
+
+    // smoothed sample rate, from the distance between sample starts
+    if(m_lastSampleStart >= 0 && begin > m_lastSampleStart)
+    {
+        double rate = 1000000.0 / (begin - m_lastSampleStart);
+        m_sampleRate = (m_sampleRate == 0) ? rate : 0.9 * m_sampleRate + 0.1 * rate;
+    }
+    m_lastSampleStart = begin;
+
+    // leave the link idle long enough to stay within the configured share
+    // of link time, this is when interactive commands get their turn
+    qint64 busy = end - begin;
+    qint64 idle = (qint64) (busy * (1.0 - m_linkShare) / m_linkShare);
+    m_timer.start((int) (idle / 1000));
+}
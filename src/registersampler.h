@@ -0,0 +1,72 @@
+#ifndef REGISTERSAMPLER_H
+#define REGISTERSAMPLER_H
+
+#include <QObject>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QList>
+#include "tdt4255board.h"
+#include "sampleringbuffer.h"
+
+#define TDT4255_SAMPLER_MAX_REGISTERS   8
+#define TDT4255_SAMPLER_BUFFER_SIZE     4096
+
+// values of all sampled registers at one point in time
+struct RegisterSample
+{
+    qint64 timestamp;       // microseconds since sampling was started
+    quint8 values[TDT4255_SAMPLER_MAX_REGISTERS];
+};
+
+typedef SampleRingBuffer<RegisterSample, TDT4255_SAMPLER_BUFFER_SIZE> RegisterSampleBuffer;
+
+// Polls a set of board registers as fast as the link allows and stores
+// timestamped samples in a ring buffer. All registers are read in one
+// batched transaction per sample. The sampler only claims a share of the
+// link time (see setLinkShare()) and yields to the event loop between
+// samples, so interactive commands are not held up behind it.
+class RegisterSampler : public QObject
+{
+    Q_OBJECT
+public:
+    explicit RegisterSampler(TDT4255Board * board, QObject *parent = 0);
+
+    bool setRegisters(QList<quint32> addresses);
+    QList<quint32> registers();
+
+    // fraction of the link time the sampler may use, in (0, 1]
+    void setLinkShare(double share);
+    double linkShare();
+
+    bool isRunning();
+    double sampleRate();
+    int droppedSamples();
+
+    RegisterSampleBuffer & samples();
+
+public slots:
+    void start();
+    void stop();
+
+signals:
+    void started();
+    void stopped();
+    void samplingError();
+
+private slots:
+    void takeSample();
+
+private:
+    TDT4255Board * m_board;
+    QList<quint32> m_registers;
+    RegisterSampleBuffer m_samples;
+
+    QTimer m_timer;
+    QElapsedTimer m_clock;
+    double m_linkShare;
+    double m_sampleRate;
+    qint64 m_lastSampleStart;
+    int m_droppedSamples;
+};
+
+#endif // REGISTERSAMPLER_H
@@ -0,0 +1,137 @@
+#include <QDebug>
+#include <QDir>
+#include <QStringList>
+#include <QFile>
+#include <QSaveFile>
+#include <QDataStream>
+#include <QCryptographicHash>
+#include <QCoreApplication>
+#include "resultcache.h"
+
+// marks a cache entry, and its layout version
+const quint32 CACHE_ENTRY_MAGIC = 0x52435631;
+
+ResultCache::ResultCache(const QString &directory)
+{
+    m_directory = directory;
+    m_mode = Enabled;
+    m_hits = 0;
+    m_misses = 0;
+}
+
+QString ResultCache::defaultDirectory()
+{
+    return QCoreApplication::applicationDirPath() + "/resultcache";
+}
+
+ResultCache::Mode ResultCache::mode() const
+{
+    return m_mode;
+}
+
+void ResultCache::setMode(Mode mode)
+{
+    m_mode = mode;
+}
+
+QByteArray ResultCache::hashFile(const QString &fileName)
+{
+    QFile f(fileName);
+    if(!f.open(QIODevice::ReadOnly))
+        return QByteArray();
+
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    if(!hash.addData(&f))
+        return QByteArray();
+
+    return hash.result();
+}
+
+QByteArray ResultCache::key(const QByteArray &bitfileHash, const QByteArray &instMem, const QByteArray &dataMem,
+                            const CompletionCriteria &criteria)
+{
+    // the lengths keep the concatenated fields from being ambiguous
+    QByteArray fields;
+    QDataStream s(&fields, QIODevice::WriteOnly);
+    s << bitfileHash << (quint32) instMem.size() << (quint32) dataMem.size()
+      << criteria.sentinelAddress << (qint32) criteria.sentinelWidth << criteria.sentinelValue
+      << criteria.sentinelMask << criteria.resultAddress << criteria.resultSize;
+
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(fields);
+    hash.addData(instMem);
+    hash.addData(dataMem);
+    return hash.result();
+}
+
+bool ResultCache::lookup(const QByteArray &key, QByteArray &result, qint64 &runTime)
+{
+    if(m_mode != Enabled)
+        return false;
+
+    QFile f(entryFileName(key));
+    if(!f.open(QIODevice::ReadOnly))
+    {
+        m_misses++;
+        return false;
+    }
+
+    QDataStream s(&f);
+    quint32 magic = 0;
+    s >> magic >> runTime >> result;
+    if(magic != CACHE_ENTRY_MAGIC || s.status() != QDataStream::Ok)
+    {
+        qDebug() << "ignoring damaged cache entry" << f.fileName();
+        m_misses++;
+        return false;
+    }
+
+    m_hits++;
+    return true;
+}
+
+bool ResultCache::store(const QByteArray &key, const QByteArray &result, qint64 runTime)
+{
+    if(m_mode == Disabled)
+        return false;
+
+    if(!QDir().mkpath(m_directory))
+        return false;
+
+    QSaveFile f(entryFileName(key));
+    if(!f.open(QIODevice::WriteOnly))
+        return false;
+
+    QDataStream s(&f);
+    s << CACHE_ENTRY_MAGIC << runTime << result;
+
+    return s.status() == QDataStream::Ok && f.commit();
+}
+
+bool ResultCache::clear()
+{
+    QDir dir(m_directory);
+    if(!dir.exists())
+        return true;
+
+    bool ok = true;
+    foreach(QString entry, dir.entryList(QStringList() << "*.result", QDir::Files))
+        ok &= dir.remove(entry);
+
+    return ok;
+}
+
+int ResultCache::hits() const
+{
+    return m_hits;
+}
+
+int ResultCache::misses() const
+{
+    return m_misses;
+}
+
+QString ResultCache::entryFileName(const QByteArray &key) const
+{
+    return m_directory + "/" + QString::fromLatin1(key.toHex()) + ".result";
+}
@@ -0,0 +1,53 @@
+#ifndef RESULTCACHE_H
+#define RESULTCACHE_H
+
+#include <QByteArray>
+#include <QString>
+#include "boardmemorymap.h"
+
+/*
+ ResultCache keeps the results of completed Ex1 runs on disk, so that a run
+ which has already been made on the same design with the same memory
+ contents is answered without the board. Entries are keyed by a SHA-1 over
+ the bitfile, the instruction and data memory contents and the completion
+ criteria; each is one file in the cache directory named after its key,
+ written atomically so an interrupted run never leaves a torn entry.
+
+ Lookups can be bypassed (Refresh, which still stores the fresh results,
+ or Disabled), and the whole cache can be invalidated with clear().
+*/
+class ResultCache
+{
+public:
+    enum Mode { Enabled, Refresh, Disabled };
+
+    explicit ResultCache(const QString & directory = defaultDirectory());
+
+    static QString defaultDirectory();
+
+    Mode mode() const;
+    void setMode(Mode mode);
+
+    // hash of a file, read in chunks; empty if it cannot be read
+    static QByteArray hashFile(const QString & fileName);
+    static QByteArray key(const QByteArray & bitfileHash, const QByteArray & instMem, const QByteArray & dataMem,
+                          const CompletionCriteria & criteria);
+
+    bool lookup(const QByteArray & key, QByteArray & result, qint64 & runTime);
+    bool store(const QByteArray & key, const QByteArray & result, qint64 runTime);
+    // removes every entry
+    bool clear();
+
+    int hits() const;
+    int misses() const;
+
+private:
+    QString entryFileName(const QByteArray & key) const;
+
+    QString m_directory;
+    Mode m_mode;
+    int m_hits;
+    int m_misses;
+};
+
+#endif // RESULTCACHE_H
@@ -0,0 +1,126 @@
+#include <QRegExp>
+#include "rpncompiler.h"
+
+RpnCompiler::RpnCompiler()
+{
+    m_foldConstants = false;
+    m_maxStackDepth = 0;
+    m_resultDepth = 0;
+}
+
+bool RpnCompiler::foldConstants() const
+{
+    return m_foldConstants;
+}
+
+void RpnCompiler::setFoldConstants(bool fold)
+{
+    m_foldConstants = fold;
+}
+
+bool RpnCompiler::compile(const QString &source)
+{
+    m_program.clear();
+    m_errorString.clear();
+    m_maxStackDepth = 0;
+    m_resultDepth = 0;
+
+    // the values of the stack, as the machine would hold them
+    QList<qint8> stack;
+
+    QStringList tokens = source.split(QRegExp("\\s+"), QString::SkipEmptyParts);
+    for(int i = 0; i < tokens.size(); i++)
+    {
+        const QString & token = tokens.at(i);
+
+        if(token == "+" || token == "-")
+        {
+            if(stack.size() < 2)
+                return fail(QString("'%1' (token %2) needs two operands on the stack").arg(token).arg(i + 1));
+
+            qint8 b = stack.takeLast();
+            qint8 a = stack.takeLast();
+            stack.append((qint8) (token == "+" ? a + b : a - b));
+            m_program.append(token == "+" ? TDT4255_EX0_INSTR_ADD : TDT4255_EX0_INSTR_SUB);
+        }
+        else
+        {
+            bool ok = false;
+            int value = token.toInt(&ok);
+            if(!ok)
+                return fail("Unrecognized symbol: " + token);
+            if(value < -128 || value > 127)
+                return fail("Values must be in range [-128, 127]");
+
+            stack.append((qint8) value);
+            m_program.append(TDT4255_EX0_INSTR_PUSH | (quint8) value);
+        }
+
+        m_maxStackDepth = qMax(m_maxStackDepth, stack.size());
+    }
+
+    m_resultDepth = stack.size();
+
+    if(m_foldConstants)
+    {
+        m_program.clear();
+        foreach(qint8 value, stack)
+            m_program.append(TDT4255_EX0_INSTR_PUSH | (quint8) value);
+        m_maxStackDepth = m_resultDepth;
+    }
+
+    return true;
+}
+
+QString RpnCompiler::errorString() const
+{
+    return m_errorString;
+}
+
+QList<quint16> RpnCompiler::program() const
+{
+    return m_program;
+}
+
+QStringList RpnCompiler::listing() const
+{
+    QStringList lines;
+    foreach(quint16 instruction, m_program)
+        lines.append(disassemble(instruction));
+
+    return lines;
+}
+
+int RpnCompiler::maxStackDepth() const
+{
+    return m_maxStackDepth;
+}
+
+int RpnCompiler::resultDepth() const
+{
+    return m_resultDepth;
+}
+
+QString RpnCompiler::disassemble(quint16 instruction)
+{
+    switch(instruction & 0xFF00)
+    {
+    case TDT4255_EX0_INSTR_PUSH:
+        return "PUSH " + QString::number((qint8) (instruction & 0xFF));
+    case TDT4255_EX0_INSTR_ADD:
+        return "ADD";
+    case TDT4255_EX0_INSTR_SUB:
+        return "SUB";
+    default:
+        return "??? " + QString::number(instruction, 16);
+    }
+}
+
+bool RpnCompiler::fail(QString message)
+{
+    m_program.clear();
+    m_maxStackDepth = 0;
+    m_resultDepth = 0;
+    m_errorString = message;
+    return false;
+}
@@ -0,0 +1,57 @@
+#ifndef RPNCOMPILER_H
+#define RPNCOMPILER_H
+
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+// Ex0 stack machine instructions, 16 bits each; PUSH carries its 8-bit
+// operand in the low byte
+#define TDT4255_EX0_INSTR_PUSH          0x0000
+#define TDT4255_EX0_INSTR_ADD           0x0100
+#define TDT4255_EX0_INSTR_SUB           0x0200
+
+/*
+ RpnCompiler translates RPN programs (e.g "3 -4 + 1 -") for the Ex0 stack
+ machine. Tokens are integers in [-128, 127] and the operators + and -,
+ where "a b -" computes a - b. The stack depth is tracked through the
+ whole program, so operators without two operands are rejected at the
+ token that underflows, and the deepest point of the stack is reported.
+
+ Without folding, the default, every token becomes one instruction,
+ which is what the exercise uses to test ADD and SUB. With folding the
+ program is evaluated with the 8-bit wrap-around of the machine; since Ex0
+ programs have no inputs, this leaves a single PUSH for every value the
+ program leaves on the stack.
+*/
+class RpnCompiler
+{
+public:
+    RpnCompiler();
+
+    bool foldConstants() const;
+    void setFoldConstants(bool fold);
+
+    bool compile(const QString & source);
+    QString errorString() const;
+
+    QList<quint16> program() const;
+    // one line per instruction, e.g "PUSH -4"
+    QStringList listing() const;
+    int maxStackDepth() const;
+    // number of values left on the stack
+    int resultDepth() const;
+
+    static QString disassemble(quint16 instruction);
+
+private:
+    bool fail(QString message);
+
+    bool m_foldConstants;
+    QList<quint16> m_program;
+    QString m_errorString;
+    int m_maxStackDepth;
+    int m_resultDepth;
+};
+
+#endif // RPNCOMPILER_H
@@ -0,0 +1,169 @@
+#include <QPainter>
+#include <QPaintEvent>
+#include <QTextStream>
+#include "sampleplotwidget.h"
+
+// upper bound on the number of samples kept for plotting and export
+const int MAX_HISTORY_SAMPLES = 200000;
+const int PLOT_MARGIN = 30;
+
+static const QColor plotColors[TDT4255_SAMPLER_MAX_REGISTERS] = {
+    QColor(0x1f, 0x77, 0xb4), QColor(0xd6, 0x27, 0x28), QColor(0x2c, 0xa0, 0x2c), QColor(0xff, 0x7f, 0x0e),
+    QColor(0x94, 0x67, 0xbd), QColor(0x8c, 0x56, 0x4b), QColor(0xe3, 0x77, 0xc2), QColor(0x7f, 0x7f, 0x7f)
+};
+
+SamplePlotWidget::SamplePlotWidget(QWidget *parent) :
+    QWidget(parent)
+{
+    m_sampler = 0;
+    m_timeWindow = 10.0;
+
+    connect(&m_refreshTimer, SIGNAL(timeout()), this, SLOT(drainSamples()));
+    m_refreshTimer.setInterval(33);
+    m_refreshTimer.start();
+}
+
+void SamplePlotWidget::setSampler(RegisterSampler *sampler)
+{
+    m_sampler = sampler;
+    clear();
+}
+
+void SamplePlotWidget::setTimeWindow(double seconds)
+{
+    if(seconds > 0)
+        m_timeWindow = seconds;
+    update();
+}
+
+int SamplePlotWidget::sampleCount()
+{
+    return m_history.size();
+}
+
+bool SamplePlotWidget::exportCsv(QIODevice *device)
+{
+    if(!device->isWritable())
+        return false;
+
+    QTextStream out(device);
+
+    out << "time_us";
+    foreach(quint32 address, m_registers)
+        out << ",reg_" << QString("%1").arg(address, 4, 16, QLatin1Char('0'));
+    out << "\n";
+
+    for(int i = 0; i < m_history.size(); i++)
+    {
+        const RegisterSample & s = m_history.at(i);
+        out << s.timestamp;
+        for(int r = 0; r < m_registers.size(); r++)
+            out << "," << (int) s.values[r];
+        out << "\n";
+    }
+
+    out.flush();
+    return out.status() == QTextStream::Ok;
+}
+
+void SamplePlotWidget::clear()
+{
+    m_history.clear();
+    if(m_sampler)
+        m_registers = m_sampler->registers();
+    update();
+}
+
+void SamplePlotWidget::drainSamples()
+{
+    if(!m_sampler || m_sampler->samples().isEmpty())
+        return;
+
+    // a new sampling run may have changed the register set
+    if(m_registers != m_sampler->registers())
+    {
+        m_history.clear();
+        m_registers = m_sampler->registers();
+    }
+
+    RegisterSample sample;
+    while(m_sampler->samples().pop(sample))
+        m_history.append(sample);
+
+    // drop the oldest tenth at once to keep trimming cheap
+    if(m_history.size() > MAX_HISTORY_SAMPLES)
+        m_history.remove(0, m_history.size() - MAX_HISTORY_SAMPLES + MAX_HISTORY_SAMPLES / 10);
+
+    update();
+}
+
+void SamplePlotWidget::paintEvent(QPaintEvent *event)
+{
+    QPainter painter(this);
+    painter.fillRect(event->rect(), palette().color(QPalette::Base));
+
+    QRect plotArea = rect().adjusted(PLOT_MARGIN, 10, -10, -PLOT_MARGIN);
+    if(plotArea.width() <= 0 || plotArea.height() <= 0)
+        return;
+
+    // axes and grid for the 8-bit value range
+    painter.setPen(Qt::lightGray);
+    for(int v = 0; v <= 256; v += 64)
+    {
+        int y = plotArea.bottom() - (v * plotArea.height()) / 256;
+        painter.drawLine(plotArea.left(), y, plotArea.right(), y);
+        painter.drawText(0, y + 4, QString::number(v));
+    }
+    painter.setPen(palette().color(QPalette::WindowText));
+    painter.drawRect(plotArea);
+
+    // legend
+    int xLegend = plotArea.left();
+    for(int r = 0; r < m_registers.size(); r++)
+    {
+        QString name = QString("%1").arg(m_registers.at(r), 4, 16, QLatin1Char('0'));
+        painter.setPen(plotColors[r]);
+        painter.drawText(xLegend, height() - 8, name);
+        xLegend += fontMetrics().width(name) + 15;
+    }
+
+    painter.setPen(palette().color(QPalette::WindowText));
+    if(m_sampler)
+        painter.drawText(plotArea.right() - 180, height() - 8,
+                         QString("%1 samples/s").arg(m_sampler->sampleRate(), 0, 'f', 0));
+
+    if(m_history.isEmpty())
+        return;
+
+    // find the first sample inside the time window
+    qint64 tEnd = m_history.last().timestamp;
+    qint64 tBegin = tEnd - (qint64) (m_timeWindow * 1000000);
+    int lo = 0, hi = m_history.size() - 1;
+    while(lo < hi)
+    {
+        int mid = (lo + hi) / 2;
+        if(m_history.at(mid).timestamp < tBegin)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    // don't draw more points than there are pixels
+    int count = m_history.size() - lo;
+    int step = qMax(1, count / plotArea.width());
+
+    painter.setRenderHint(QPainter::Antialiasing);
+    for(int r = 0; r < m_registers.size(); r++)
+    {
+        QPolygonF line;
+        for(int i = lo; i < m_history.size(); i += step)
+        {
+            const RegisterSample & s = m_history.at(i);
+            double x = plotArea.left() + (double) (s.timestamp - tBegin) * plotArea.width() / (tEnd - tBegin + 1);
+            double y = plotArea.bottom() - (double) s.values[r] * plotArea.height() / 256;
+            line << QPointF(x, y);
+        }
+        painter.setPen(plotColors[r]);
+        painter.drawPolyline(line);
+    }
+}
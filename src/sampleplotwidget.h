@@ -0,0 +1,46 @@
+#ifndef SAMPLEPLOTWIDGET_H
+#define SAMPLEPLOTWIDGET_H
+
+#include <QWidget>
+#include <QTimer>
+#include <QVector>
+#include <QIODevice>
+#include "registersampler.h"
+
+// Live plot of the samples collected by a RegisterSampler. The widget
+// periodically drains the sampler's ring buffer into its own bounded
+// history, which is what gets plotted and exported.
+class SamplePlotWidget : public QWidget
+{
+    Q_OBJECT
+public:
+    explicit SamplePlotWidget(QWidget *parent = 0);
+
+    void setSampler(RegisterSampler * sampler);
+
+    // length of the plotted time window, in seconds
+    void setTimeWindow(double seconds);
+
+    int sampleCount();
+
+    // writes the collected history as CSV, one line per sample
+    bool exportCsv(QIODevice * device);
+
+public slots:
+    void clear();
+
+protected:
+    void paintEvent(QPaintEvent *event);
+
+private slots:
+    void drainSamples();
+
+private:
+    RegisterSampler * m_sampler;
+    QList<quint32> m_registers;
+    QVector<RegisterSample> m_history;
+    QTimer m_refreshTimer;
+    double m_timeWindow;
+};
+
+#endif // SAMPLEPLOTWIDGET_H
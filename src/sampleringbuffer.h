@@ -0,0 +1,73 @@
+#ifndef SAMPLERINGBUFFER_H
+#define SAMPLERINGBUFFER_H
+
+#include <QAtomicInt>
+
+// Fixed-capacity single-producer/single-consumer ring buffer. push() and
+// pop() may run concurrently from one producer and one consumer thread
+// without locking; the head index is only written by the producer and the
+// tail index only by the consumer. One slot is kept free to tell a full
+// buffer from an empty one, so at most Capacity-1 items are stored.
+template <typename T, int Capacity>
+class SampleRingBuffer
+{
+public:
+    SampleRingBuffer() : m_head(0), m_tail(0) {}
+
+    // producer side, returns false and drops the item if the buffer is full
+    bool push(const T & item)
+    {
+        int head = m_head.loadAcquire();
+        int next = (head + 1) % Capacity;
+
+        if(next == m_tail.loadAcquire())
+            return false;
+
+        m_items[head] = item;
+        m_head.storeRelease(next);
+        return true;
+    }
+
+    // consumer side, returns false if the buffer is empty
+    bool pop(T & item)
+    {
+        int tail = m_tail.loadAcquire();
+
+        if(tail == m_head.loadAcquire())
+            return false;
+
+        item = m_items[tail];
+        m_tail.storeRelease((tail + 1) % Capacity);
+        return true;
+    }
+
+    int size() const
+    {
+        int count = m_head.loadAcquire() - m_tail.loadAcquire();
+        return (count < 0) ? count + Capacity : count;
+    }
+
+    bool isEmpty() const
+    {
+        return size() == 0;
+    }
+
+    int capacity() const
+    {
+        return Capacity - 1;
+    }
+
+    // only safe while neither side is active
+    void clear()
+    {
+        m_head.storeRelease(0);
+        m_tail.storeRelease(0);
+    }
+
+private:
+    T m_items[Capacity];
+    QAtomicInt m_head;
+    QAtomicInt m_tail;
+};
+
+#endif // SAMPLERINGBUFFER_H
@@ -0,0 +1,223 @@
+#include <string.h>
+#include "snapshothistory.h"
+
+SnapshotHistory::SnapshotHistory(int memoryBudget, int keyframeInterval)
+{
+    m_memoryBudget = memoryBudget;
+    m_keyframeInterval = qMax(1, keyframeInterval);
+    clear();
+}
+
+void SnapshotHistory::append(const QByteArray &snapshot, QString label)
+{
+    Entry e;
+    e.size = snapshot.size();
+    e.label = label;
+    e.timestamp = QDateTime::currentDateTime();
+
+    int changedBytes = 0;
+    if(!m_entries.isEmpty())
+    {
+        // ranges past the end of a shrunk snapshot carry no data
+        foreach(DiffRange r, MemoryDiff::compare(m_latest, snapshot))
+        {
+            r.length = qMin(r.end(), snapshot.size()) - r.offset;
+            if(r.length > 0)
+            {
+                e.changes.append(r);
+                changedBytes += r.length;
+            }
+        }
+    }
+
+    int deltaCost = changedBytes + e.changes.size() * (int) sizeof(DiffRange);
+
+    if(m_entries.isEmpty() || m_sinceKeyframe + 1 >= m_keyframeInterval || deltaCost >= snapshot.size())
+    {
+        e.keyframe = true;
+        e.payload = snapshot;
+        m_sinceKeyframe = 0;
+    }
+    else
+    {
+        e.keyframe = false;
+        e.payload.reserve(changedBytes);
+        foreach(DiffRange r, e.changes)
+            e.payload.append(snapshot.constData() + r.offset, r.length);
+        m_sinceKeyframe++;
+    }
+
+    m_entries.append(e);
+    m_memoryUsage += entryCost(e) + snapshot.size() - m_latest.size();
+    m_latest = snapshot;
+
+    enforceBudget();
+}
+
+void SnapshotHistory::clear()
+{
+    m_entries.clear();
+    m_memoryUsage = 0;
+    m_sinceKeyframe = 0;
+    m_cachedIndex = -1;
+    m_cached.clear();
+    m_latest.clear();
+}
+
+int SnapshotHistory::count() const
+{
+    return m_entries.size();
+}
+
+bool SnapshotHistory::isEmpty() const
+{
+    return m_entries.isEmpty();
+}
+
+QByteArray SnapshotHistory::snapshot(int index)
+{
+    if(index < 0 || index >= m_entries.size())
+        return QByteArray();
+
+    if(index == m_entries.size() - 1)
+        return m_latest;
+
+    if(index == m_cachedIndex)
+        return m_cached;
+
+    // the nearest keyframe at or before the requested snapshot
+    int keyframe = index;
+    while(!m_entries.at(keyframe).keyframe)
+        keyframe--;
+
+    // continue from the cached snapshot if it lies on the way
+    int current;
+    QByteArray result;
+    if(m_cachedIndex >= keyframe && m_cachedIndex < index)
+    {
+        current = m_cachedIndex;
+        result = m_cached;
+    }
+    else
+    {
+        current = keyframe;
+        result = m_entries.at(keyframe).payload;
+    }
+
+    while(current < index)
+    {
+        current++;
+        applyDelta(result, m_entries.at(current));
+    }
+
+    m_memoryUsage += result.size() - m_cached.size();
+    m_cachedIndex = index;
+    m_cached = result;
+    return result;
+}
+
+QList<DiffRange> SnapshotHistory::changes(int index) const
+{
+    if(index < 0 || index >= m_entries.size())
+        return QList<DiffRange>();
+
+    return m_entries.at(index).changes.toList();
+}
+
+QString SnapshotHistory::label(int index) const
+{
+    if(index < 0 || index >= m_entries.size())
+        return QString();
+
+    return m_entries.at(index).label;
+}
+
+QDateTime SnapshotHistory::timestamp(int index) const
+{
+    if(index < 0 || index >= m_entries.size())
+        return QDateTime();
+
+    return m_entries.at(index).timestamp;
+}
+
+int SnapshotHistory::memoryUsage() const
+{
+    return m_memoryUsage;
+}
+
+int SnapshotHistory::memoryBudget() const
+{
+    return m_memoryBudget;
+}
+
+void SnapshotHistory::setMemoryBudget(int bytes)
+{
+    m_memoryBudget = bytes;
+    enforceBudget();
+}
+
+int SnapshotHistory::keyframeInterval() const
+{
+    return m_keyframeInterval;
+}
+
+int SnapshotHistory::entryCost(const Entry &e)
+{
+    return (int) sizeof(Entry) + e.payload.size() + e.changes.size() * (int) sizeof(DiffRange)
+            + e.label.size() * (int) sizeof(QChar);
+}
+
+void SnapshotHistory::applyDelta(QByteArray &base, const Entry &delta) const
+{
+    if(delta.keyframe)
+    {
+        base = delta.payload;
+        return;
+    }
+
+    base.resize(delta.size);
+    char * dst = base.data();
+    const char * src = delta.payload.constData();
+
+    foreach(DiffRange r, delta.changes)
+    {
+        memcpy(dst + r.offset, src, r.length);
+        src += r.length;
+    }
+}
+
+void SnapshotHistory::enforceBudget()
+{
+    // the usage counts the latest and the cached snapshot; room is kept
+    // for the cache to be filled, with a snapshot as large as the latest
+    int cacheReserve = m_cached.isEmpty() ? m_latest.size() : 0;
+
+    // the newest snapshot is always kept
+    while(m_memoryUsage + cacheReserve > m_memoryBudget && m_entries.size() > 1)
+    {
+        // the second snapshot becomes the new base of the history
+        Entry & next = m_entries[1];
+        if(!next.keyframe)
+        {
+            QByteArray full = m_entries.at(0).payload;
+            applyDelta(full, next);
+
+            m_memoryUsage -= entryCost(next);
+            next.keyframe = true;
+            next.payload = full;
+            m_memoryUsage += entryCost(next);
+        }
+
+        m_memoryUsage -= entryCost(m_entries.first());
+        m_entries.removeFirst();
+
+        if(m_cachedIndex >= 0)
+            m_cachedIndex--;
+        if(m_cachedIndex < 0 && !m_cached.isEmpty())
+        {
+            m_memoryUsage -= m_cached.size();
+            m_cached.clear();
+            cacheReserve = m_latest.size();
+        }
+    }
+}
@@ -0,0 +1,67 @@
+#ifndef SNAPSHOTHISTORY_H
+#define SNAPSHOTHISTORY_H
+
+#include <QByteArray>
+#include <QDateTime>
+#include <QList>
+#include <QVector>
+#include "memorydiff.h"
+
+// Bounded history of memory snapshots. Each snapshot is stored as a delta
+// against its predecessor, with a full keyframe every keyframeInterval()
+// snapshots (or when a delta would not be smaller than the snapshot). Any
+// snapshot is rebuilt from its keyframe by applying at most that many
+// deltas, and stepping through neighbouring snapshots reuses the last one
+// rebuilt. When the memory budget is exceeded the oldest snapshots are
+// discarded; the budget also covers the latest and the last rebuilt
+// snapshot, which are kept in full.
+class SnapshotHistory
+{
+public:
+    SnapshotHistory(int memoryBudget = 4 * 1024 * 1024, int keyframeInterval = 32);
+
+    void append(const QByteArray & snapshot, QString label = QString());
+    void clear();
+
+    int count() const;
+    bool isEmpty() const;
+
+    QByteArray snapshot(int index);
+    // differences of the snapshot against its predecessor
+    QList<DiffRange> changes(int index) const;
+    QString label(int index) const;
+    QDateTime timestamp(int index) const;
+
+    int memoryUsage() const;
+    int memoryBudget() const;
+    void setMemoryBudget(int bytes);
+    int keyframeInterval() const;
+
+private:
+    struct Entry
+    {
+        bool keyframe;
+        int size;                       // size of the snapshot
+        QByteArray payload;             // full snapshot, or the changed bytes
+        QVector<DiffRange> changes;     // against the previous snapshot
+        QString label;
+        QDateTime timestamp;
+    };
+
+    static int entryCost(const Entry & e);
+    void applyDelta(QByteArray & base, const Entry & delta) const;
+    void enforceBudget();
+
+    QList<Entry> m_entries;
+    int m_memoryBudget;
+    int m_keyframeInterval;
+    int m_memoryUsage;
+    int m_sinceKeyframe;
+
+    // the most recently rebuilt snapshot, and the last one appended
+    int m_cachedIndex;
+    QByteArray m_cached;
+    QByteArray m_latest;
+};
+
+#endif // SNAPSHOTHISTORY_H
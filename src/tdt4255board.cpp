@@ -1,14 +1,52 @@
 #include <QDebug>
 #include <QMessageBox>
 #include <QDir>
+#include <QDateTime>
+#include <QSet>
 #include "tdt4255board.h"
 
 TDT4255Board* TDT4255Board::m_instance = 0;
 
+// replies to read commands are this many bytes long
+const int REGISTER_REPLY_SIZE = 4;
+// maximum number of read commands in flight during a transaction, keeps
+// the board's receive buffer from overflowing
+const int MAX_PENDING_READS = 32;
+// sampled verification reads this share of the bytes, and at least
+// MIN_VERIFY_SAMPLES of them
+const int VERIFY_SAMPLE_DIVISOR = 8;
+const int MIN_VERIFY_SAMPLES = 16;
+
+BoardOperation BoardOperation::read(quint32 address, int length)
+{
+    BoardOperation op;
+    op.type = Read;
+    op.address = address;
+    op.data = QByteArray(length, 0);
+    return op;
+}
+
+BoardOperation BoardOperation::write(quint32 address, QByteArray data)
+{
+    BoardOperation op;
+    op.type = Write;
+    op.address = address;
+    op.data = data;
+    return op;
+}
+
 TDT4255Board::TDT4255Board() :
     QObject(0)
 {
     m_serialPort = new QSerialPort(this);
+    m_autoReconnect = true;
+    m_linkLocked = false;
+
+    m_hotplugMonitor = new BoardHotplugMonitor(this);
+    connect(m_hotplugMonitor, SIGNAL(boardAttached(QString)), this, SLOT(hotplugAttached(QString)));
+    connect(m_hotplugMonitor, SIGNAL(boardDetached(QString)), this, SLOT(hotplugDetached(QString)));
+    if(!m_hotplugMonitor->start())
+        qDebug() << "hotplug monitoring not available, board must be reconnected manually";
 }
 
 bool TDT4255Board::executeProgrammingCommand(QString cmdString, QString expectedReply, bool stripACK)
@@ -132,6 +170,16 @@ void TDT4255Board::destroyInstance()
 }
 
 bool TDT4255Board::connectToBoard()
+{
+    QString error;
+    if(openBoard(error))
+        return true;
+
+    QMessageBox::critical(0, "Error", error);
+    return false;
+}
+
+bool TDT4255Board::openBoard(QString &error)
 {
     if(m_serialPort->isOpen())
     {
@@ -141,23 +189,29 @@ bool TDT4255Board::connectToBoard()
 
     // TODO make the comport configurable
 #ifdef Q_OS_LINUX
-    // find the first match for /dev/ttyACM*
-    QDir d("/dev","ttyACM*", QDir::Name, QDir::System);
-    if(d.entryInfoList().size() == 0)
+    // prefer the port that udev reports for the board VID/PID, and
+    // fall back to the first match for /dev/ttyACM*
+    m_portLocation = m_hotplugMonitor->findAttachedBoard();
+    if(m_portLocation.isEmpty())
     {
-        QMessageBox::critical(0, "Error", "/dev/ttyACM* not found, ensure the board is connected and powered on");
-        emit connStatusChange(false);
-        return false;
+        QDir d("/dev","ttyACM*", QDir::Name, QDir::System);
+        if(d.entryInfoList().size() == 0)
+        {
+            error = "/dev/ttyACM* not found, ensure the board is connected and powered on";
+            emit connStatusChange(false);
+            return false;
+        }
+        m_portLocation = d.entryInfoList().at(0).absoluteFilePath();
     }
-    m_serialPort->setPortName(d.entryInfoList().at(0).absoluteFilePath());
 #else
-    m_serialPort->setPortName("COM5");
+    m_portLocation = "COM5";
 #endif
+    m_serialPort->setPortName(m_portLocation);
 
     if(!m_serialPort->open(QIODevice::ReadWrite))
     {
-        QMessageBox::critical(0, "Error", "Error opening serial port: " + m_serialPort->errorString()
-                                + "\nPort: " + m_serialPort->portName());
+        error = "Error opening serial port: " + m_serialPort->errorString()
+                + "\nPort: " + m_serialPort->portName();
         emit connStatusChange(false);
         return false;
     }
@@ -179,7 +233,82 @@ void TDT4255Board::disconnectFromBoard()
     m_serialPort->close();
 }
 
-bool TDT4255Board::verifyConnection(quint16 magicRegAddr, QString magicRegExpectedVal)
+void TDT4255Board::setAutoReconnect(bool enable)
+{
+    m_autoReconnect = enable;
+}
+
+bool TDT4255Board::autoReconnect()
+{
+    return m_autoReconnect;
+}
+
+void TDT4255Board::lockLink()
+{
+    m_linkLocked = true;
+}
+
+void TDT4255Board::unlockLink()
+{
+    m_linkLocked = false;
+
+    QList<QPair<QString, bool> > pending = m_pendingHotplug;
+    m_pendingHotplug.clear();
+    for(int i = 0; i < pending.size(); i++)
+    {
+        if(pending.at(i).second)
+            hotplugAttached(pending.at(i).first);
+        else
+            hotplugDetached(pending.at(i).first);
+    }
+}
+
+bool TDT4255Board::isLinkLocked()
+{
+    return m_linkLocked;
+}
+
+void TDT4255Board::hotplugAttached(QString devNode)
+{
+    if(m_linkLocked)
+    {
+        m_pendingHotplug.append(qMakePair(devNode, true));
+        return;
+    }
+
+    if(!m_autoReconnect || m_serialPort->isOpen())
+        return;
+
+    qDebug() << "board reattached at" << devNode << ", reconnecting";
+
+    // nobody asked for this connection, so failures are only reported
+    // through connStatusChange()
+    QString error;
+    if(openBoard(error))
+        emit boardAttached();
+    else
+        qDebug() << "reconnecting failed:" << error;
+}
+
+void TDT4255Board::hotplugDetached(QString devNode)
+{
+    if(m_linkLocked)
+    {
+        m_pendingHotplug.append(qMakePair(devNode, false));
+        return;
+    }
+
+    if(!m_serialPort->isOpen() || devNode != m_portLocation)
+        return;
+
+    qDebug() << "board detached from" << devNode;
+
+    disconnectFromBoard();
+    emit connStatusChange(false);
+    emit boardDetached();
+}
+
+bool TDT4255Board::verifyConnection(quint32 magicRegAddr, QString magicRegExpectedVal)
 {
     // verify if port is open
     if(!m_serialPort->isOpen())
@@ -290,59 +419,66 @@ bool TDT4255Board::flashBitfile(QString fileName)
     return true;
 }
 
-bool TDT4255Board::readRegister(quint16 address, quint8 &value)
+BoardMemoryMap & TDT4255Board::memoryMap()
+{
+    return m_memoryMap;
+}
+
+bool TDT4255Board::loadMemoryMap(QString fileName)
+{
+    return m_memoryMap.load(fileName);
+}
+
+bool TDT4255Board::readRegister(quint32 address, quint8 &value)
 {
     if(!m_serialPort->isOpen())
         return false;
 
+    if(!checkAddressRange(address, 1))
+        return false;
+
     // example command string for reading register at address 0x0003:
     // r 0003
-    QString commandString = QString("r %1\n").arg((ushort) address, 4, 16, QLatin1Char('0'));
+    QString commandString = QString("r %1\n").arg(formatAddress(address));
     m_serialPort->write(commandString.toLocal8Bit());
     // wait for response, timeout after 1 sec
     m_serialPort->waitForReadyRead(1000);
     QByteArray receivedData = m_serialPort->readAll();
 
-    if(receivedData.size() != 4)
+    if(receivedData.size() != REGISTER_REPLY_SIZE)
     {
         qDebug() << "readRegister got invalid response of size " << receivedData.size() <<
                     ": " << receivedData.toHex();
         return false;
     }
 
-    // convert hex string to number
-    bool conversionOK = false;
-    quint8 val = (quint8) QString::fromLocal8Bit(receivedData).toUInt(&conversionOK,16);
-
-    if(!conversionOK)
-    {
-        qDebug() << "readRegister got invalid data: " << receivedData;
-        return false;
-    }
-
-    value = val;
-
-    return true;
+    return parseRegisterReply(receivedData, value);
 }
 
-bool TDT4255Board::writeRegister(quint16 address, quint8 value)
+bool TDT4255Board::writeRegister(quint32 address, quint8 value)
 {
     if(!m_serialPort->isOpen())
         return false;
 
+    if(!checkAddressRange(address, 1))
+        return false;
+
     // example of writing 0xfe at address 0x8000:
     // w fe 8000
     QString commandString = QString("w %1 %2\n")
             .arg(value, 2, 16, QLatin1Char('0'))
-            .arg(address, 4, 16, QLatin1Char('0'));
+            .arg(formatAddress(address));
 
     m_serialPort->write(commandString.toLocal8Bit());
 
     return true;
 }
 
-bool TDT4255Board::readBuffer(quint16 baseAddress, QByteArray &buffer)
+bool TDT4255Board::readBuffer(quint32 baseAddress, QByteArray &buffer)
 {
+    if(!checkAddressRange(baseAddress, buffer.size()))
+        return false;
+
     clearStaleData();
 
     bool ok = true;
@@ -364,8 +500,11 @@ bool TDT4255Board::readBuffer(quint16 baseAddress, QByteArray &buffer)
     return true;
 }
 
-bool TDT4255Board::writeBuffer(quint16 baseAddress, QByteArray buffer)
+bool TDT4255Board::writeBuffer(quint32 baseAddress, const QByteArray &buffer)
 {
+    if(!checkAddressRange(baseAddress, buffer.size()))
+        return false;
+
     bool ok = true;
     for(int i = 0; i < buffer.size(); i++)
     {
@@ -385,6 +524,280 @@ bool TDT4255Board::writeBuffer(quint16 baseAddress, QByteArray buffer)
     return true;
 }
 
+bool TDT4255Board::verifyBuffer(quint32 baseAddress, const QByteArray &expected, VerifyMode mode, VerifyMode *usedMode)
+{
+    // the checksum unit takes 16-bit lengths
+    if(mode == VerifyChecksum && (!m_memoryMap.hasChecksumUnit() || expected.size() > 0xFFFF))
+        mode = VerifySampled;
+    // sampling small ranges saves nothing over reading them whole
+    if(mode == VerifySampled && expected.size() <= MIN_VERIFY_SAMPLES)
+        mode = VerifyFull;
+    if(usedMode)
+        *usedMode = mode;
+
+    if(!checkAddressRange(baseAddress, expected.size()))
+        return false;
+
+    QList<BoardOperation> ops;
+
+    if(mode == VerifyChecksum)
+    {
+        // program the range and read the CRC back in one batch
+        quint32 unit = m_memoryMap.checksumAddress();
+        QByteArray range(6, 0);
+        for(int i = 0; i < 4; i++)
+            range[i] = (char) (baseAddress >> (8 * i));
+        range[4] = (char) expected.size();
+        range[5] = (char) (expected.size() >> 8);
+
+        ops << BoardOperation::write(unit, range)
+            << BoardOperation::read(unit + 8, 4);
+        if(!executeTransaction(ops, false))
+            return false;
+
+        const QByteArray & reply = ops.at(1).data;
+        quint32 crc = 0;
+        for(int i = 3; i >= 0; i--)
+            crc = (crc << 8) | (quint8) reply.at(i);
+
+        return crc == crc32(expected);
+    }
+
+    // the reads of a batch are pipelined, which a byte-wise readBuffer()
+    // is not
+    QList<int> offsets;
+    if(mode == VerifySampled)
+    {
+        // the ends are always checked, the rest at distinct random offsets.
+        // A local xorshift keeps the global qrand() sequence untouched
+        int samples = qMax(MIN_VERIFY_SAMPLES, expected.size() / VERIFY_SAMPLE_DIVISOR);
+        QSet<int> picked;
+        picked << 0 << expected.size() - 1;
+        quint32 seed = (quint32) QDateTime::currentMSecsSinceEpoch() | 1;
+        while(picked.size() < samples)
+        {
+            seed ^= seed << 13;
+            seed ^= seed >> 17;
+            seed ^= seed << 5;
+            picked << (int) (seed % expected.size());
+        }
+        offsets = picked.toList();
+        qSort(offsets);
+
+        foreach(int offset, offsets)
+            ops << BoardOperation::read(baseAddress + offset, 1);
+    }
+    else
+        ops << BoardOperation::read(baseAddress, expected.size());
+
+    if(!executeTransaction(ops))
+        return false;
+
+    if(mode == VerifyFull)
+        return ops.at(0).data == expected;
+
+    for(int i = 0; i < offsets.size(); i++)
+    {
+        if(ops.at(i).data.at(0) != expected.at(offsets.at(i)))
+        {
+            qDebug() << "verifyBuffer: mismatch at" << formatAddress(baseAddress + offsets.at(i));
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool TDT4255Board::checkAddressRange(quint32 baseAddress, quint32 length)
+{
+    // the last accessed address must still be representable on the wire,
+    // otherwise the address would silently wrap around
+    if(length > 0 && (quint64) baseAddress + length - 1 > m_memoryMap.maxAddress())
+    {
+        qDebug() << "address range" << QString::number(baseAddress, 16) << "+" << length
+                 << "exceeds the" << m_memoryMap.addressBits() << "bit address space of the board";
+        return false;
+    }
+
+    return true;
+}
+
+quint32 TDT4255Board::crc32(const QByteArray &data)
+{
+    // local stand-in for the checksum unit: reflected CRC-32 with the
+    // IEEE 802.3 polynomial, a table lookup per byte
+    static quint32 table[256];
+    static bool tableReady = false;
+    if(!tableReady)
+    {
+        for(quint32 i = 0; i < 256; i++)
+        {
+            quint32 c = i;
+            for(int k = 0; k < 8; k++)
+                c = (c & 1) ? (0xEDB88320 ^ (c >> 1)) : (c >> 1);
+            table[i] = c;
+        }
+        tableReady = true;
+    }
+
+    quint32 crc = 0xFFFFFFFF;
+    for(int i = 0; i < data.size(); i++)
+        crc = table[(crc ^ (quint8) data.at(i)) & 0xFF] ^ (crc >> 8);
+
+    return crc ^ 0xFFFFFFFF;
+}
+
+QString TDT4255Board::formatAddress(quint32 address)
+{
+    // addresses that fit into 16 bits always use the four-digit form so
+    // that boards which only speak the narrow protocol keep working, e.g
+    // r 8000 vs. r 00012000
+    if(address <= 0xFFFF)
+        return QString("%1").arg(address, 4, 16, QLatin1Char('0'));
+    else
+        return QString("%1").arg(address, 8, 16, QLatin1Char('0'));
+}
+
+bool TDT4255Board::executeTransaction(QList<BoardOperation> &operations, bool reportProgress, bool quickDrain)
+{
+    if(!m_serialPort->isOpen())
+        return false;
+
+    int totalBytes = 0;
+    int totalReads = 0;
+    for(int i = 0; i < operations.size(); i++)
+    {
+        if(!checkAddressRange(operations.at(i).address, operations.at(i).data.size()))
+            return false;
+        totalBytes += operations.at(i).data.size();
+        if(operations.at(i).type == BoardOperation::Read)
+            totalReads += operations.at(i).data.size();
+    }
+
+    // a late reply to an earlier, timed out read would otherwise be taken
+    // for one of this batch; the wait is skipped for quick drains, where
+    // it would dominate the cost of the transaction
+    if(quickDrain)
+        m_serialPort->readAll();
+    else
+        clearStaleData();
+
+    // destinations of the issued reads as (operation, byte) pairs, in the
+    // order in which their replies arrive
+    QList<QPair<int, int> > readTargets;
+    readTargets.reserve(totalReads);
+    int completedReads = 0;
+    int issuedBytes = 0;
+    QByteArray commands;
+    QByteArray replies;
+
+    for(int i = 0; i < operations.size(); i++)
+    {
+        BoardOperation::Type type = operations.at(i).type;
+        quint32 address = operations.at(i).address;
+        int length = operations.at(i).data.size();
+
+        for(int j = 0; j < length; j++, address++)
+        {
+            if(type == BoardOperation::Read)
+            {
+                // push out the queued commands and wait for replies while
+                // the window of pending reads is full
+                while(readTargets.size() - completedReads >= MAX_PENDING_READS)
+                {
+                    m_serialPort->write(commands);
+                    commands.clear();
+                    if(!collectReplies(operations, readTargets, completedReads, replies))
+                        return false;
+                    reportTransactionProgress(reportProgress, issuedBytes - (readTargets.size() - completedReads), totalBytes);
+                }
+
+                commands.append(QString("r %1\n").arg(formatAddress(address)).toLocal8Bit());
+                readTargets.append(qMakePair(i, j));
+            }
+            else
+            {
+                commands.append(QString("w %1 %2\n")
+                                .arg((quint8) operations.at(i).data.at(j), 2, 16, QLatin1Char('0'))
+                                .arg(formatAddress(address)).toLocal8Bit());
+            }
+            issuedBytes++;
+        }
+    }
+
+    if(!commands.isEmpty())
+        m_serialPort->write(commands);
+
+    while(completedReads < readTargets.size())
+    {
+        if(!collectReplies(operations, readTargets, completedReads, replies))
+            return false;
+        reportTransactionProgress(reportProgress, issuedBytes - (readTargets.size() - completedReads), totalBytes);
+    }
+
+    if(!replies.isEmpty())
+    {
+        qDebug() << "executeTransaction got unexpected trailing data:" << replies.toHex();
+        return false;
+    }
+
+    reportTransactionProgress(reportProgress, totalBytes, totalBytes);
+
+    return true;
+}
+
+void TDT4255Board::reportTransactionProgress(bool enabled, int current, int max)
+{
+    if(enabled)
+        emit bufferOperationProgress(current, max);
+}
+
+bool TDT4255Board::collectReplies(QList<BoardOperation> &operations, const QList<QPair<int, int> > &readTargets,
+                                  int &completedReads, QByteArray &replies)
+{
+    if(!m_serialPort->waitForReadyRead(1000))
+    {
+        qDebug() << "executeTransaction timed out after" << completedReads << "of" << readTargets.size() << "reads";
+        return false;
+    }
+    replies.append(m_serialPort->readAll());
+
+    // consume all complete replies, partial ones stay for the next round
+    int pos = 0;
+    while(pos + REGISTER_REPLY_SIZE <= replies.size() && completedReads < readTargets.size())
+    {
+        quint8 val = 0;
+        if(!parseRegisterReply(replies.mid(pos, REGISTER_REPLY_SIZE), val))
+            return false;
+
+        const QPair<int, int> & target = readTargets.at(completedReads);
+        operations[target.first].data[target.second] = (char) val;
+
+        completedReads++;
+        pos += REGISTER_REPLY_SIZE;
+    }
+    replies.remove(0, pos);
+
+    return true;
+}
+
+bool TDT4255Board::parseRegisterReply(const QByteArray &reply, quint8 &value)
+{
+    // convert hex string to number
+    bool conversionOK = false;
+    quint8 val = (quint8) QString::fromLocal8Bit(reply).toUInt(&conversionOK,16);
+
+    if(!conversionOK)
+    {
+        qDebug() << "got invalid register data: " << reply;
+        return false;
+    }
+
+    value = val;
+
+    return true;
+}
+
 void TDT4255Board::clearStaleData()
 {
     // read the stale data
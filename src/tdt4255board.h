@@ -4,7 +4,10 @@
 #include <QObject>
 #include <QMutex>
 #include <QtSerialPort/QtSerialPort>
+#include "boardhotplugmonitor.h"
+#include "boardmemorymap.h"
 
+// default memory layout, see BoardMemoryMap for overriding it at runtime
 #define TDT4255_EX0_REGADR_MAGIC_ID     0x4000
 #define TDT4255_EX0_REGVAL_MAGIC_ID     "c0decafe"
 #define TDT4255_EX0_REGADR_STACKTOP     0x0000
@@ -20,25 +23,79 @@
 #define TDT4255_EX1_DATMEM_BASEADDR     0x8000
 #define TDT4255_EX1_INSMEM_BASEADDR     0xC000
 
+// one read or write of a scatter-gather transaction, see
+// TDT4255Board::executeTransaction()
+struct BoardOperation
+{
+    enum Type { Read, Write };
+
+    static BoardOperation read(quint32 address, int length);
+    static BoardOperation write(quint32 address, QByteArray data);
+
+    Type type;
+    quint32 address;
+    QByteArray data;        // bytes to write, or the bytes read back
+};
+
 class TDT4255Board : public QObject
 {
     Q_OBJECT
 public:
+    // how verifyBuffer() checks a written range
+    enum VerifyMode { VerifyFull, VerifyChecksum, VerifySampled };
+
     static TDT4255Board* getInstance();
     static void destroyInstance();
 
+    // connectToBoard() reports failures in a message box, openBoard()
+    // only through error, for callers without a user to answer it
     bool connectToBoard();
+    bool openBoard(QString & error);
     void disconnectFromBoard();
 
-    bool verifyConnection(quint16 magicRegAddr, QString magicRegExpectedVal);
+    // when enabled, a board that is plugged in again is reconnected
+    // automatically and boardAttached() is emitted
+    void setAutoReconnect(bool enable);
+    bool autoReconnect();
 
-    bool flashBitfile(QString fileName);
+    bool verifyConnection(quint32 magicRegAddr, QString magicRegExpectedVal);
 
-    bool readRegister(quint16 address, quint8 &value);
-    bool writeRegister(quint16 address, quint8 value);
+    bool flashBitfile(QString fileName);
 
-    bool readBuffer(quint16 baseAddress, QByteArray & buffer);
-    bool writeBuffer(quint16 baseAddress, QByteArray buffer);
+    BoardMemoryMap & memoryMap();
+    bool loadMemoryMap(QString fileName);
+
+    // addresses above 0xFFFF are only valid on boards that use the wide
+    // (32-bit) address form, see BoardMemoryMap::addressBits()
+    bool readRegister(quint32 address, quint8 &value);
+    bool writeRegister(quint32 address, quint8 value);
+
+    bool readBuffer(quint32 baseAddress, QByteArray & buffer);
+    bool writeBuffer(quint32 baseAddress, const QByteArray & buffer);
+
+    // checks that the board holds expected at baseAddress. VerifyChecksum
+    // compares the CRC-32 computed by the checksum unit of the framework
+    // with one computed locally, and falls back to VerifySampled when the
+    // memory map declares no unit; VerifySampled reads back a random
+    // sample of the bytes, VerifyFull all of them. The mode that was
+    // actually used is stored in usedMode.
+    bool verifyBuffer(quint32 baseAddress, const QByteArray & expected, VerifyMode mode = VerifyChecksum,
+                      VerifyMode * usedMode = 0);
+
+    // runs all operations in order as one pipelined batch: commands are
+    // streamed to the board without waiting for each reply, and the read
+    // operations have their data filled in once the batch completes.
+    // Stale replies are drained with a short wait first; with quickDrain
+    // only what has already arrived is dropped, which is for callers that
+    // issue many small batches and never time out reads, like the sampler
+    bool executeTransaction(QList<BoardOperation> & operations, bool reportProgress = true, bool quickDrain = false);
+
+    // a caller that owns the link for a longer sequence (e.g a program run)
+    // locks it; background users like the sampler skip their turn, and
+    // hotplug events are handled once it is unlocked again
+    void lockLink();
+    void unlockLink();
+    bool isLinkLocked();
 
 private:
     TDT4255Board();
@@ -52,16 +109,34 @@ private:
 
 protected:
     QSerialPort * m_serialPort;
+    QString m_portLocation;
+    BoardHotplugMonitor * m_hotplugMonitor;
+    bool m_autoReconnect;
+    bool m_linkLocked;
+    QList<QPair<QString, bool> > m_pendingHotplug;  // (device node, attached)
+    BoardMemoryMap m_memoryMap;
 
     bool executeProgrammingCommand(QString cmdString, QString expectedReply, bool stripACK = true);
     bool sendBitfile(QString fileName);
     void clearStaleData();
+    bool checkAddressRange(quint32 baseAddress, quint32 length);
+    static quint32 crc32(const QByteArray & data);
+    bool parseRegisterReply(const QByteArray & reply, quint8 &value);
+    bool collectReplies(QList<BoardOperation> & operations, const QList<QPair<int, int> > & readTargets,
+                        int &completedReads, QByteArray & replies);
+    void reportTransactionProgress(bool enabled, int current, int max);
+    QString formatAddress(quint32 address);
 
 signals:
     void bufferOperationProgress(int current, int max);
     void bitfileOperationProgress(int current, int max);
     void connStatusChange(bool status);
+    void boardAttached();
+    void boardDetached();
 
+private slots:
+    void hotplugAttached(QString devNode);
+    void hotplugDetached(QString devNode);
 
 };
 